@@ -0,0 +1,168 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "aesctr.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define AES128_EXPAND(rk, i, rcon) \
+    rk[i] = aes128_expand_step(rk[i - 1], _mm_aeskeygenassist_si128(rk[i - 1], rcon))
+
+__attribute__((target("aes")))
+static __m128i aes128_expand_step(__m128i key, __m128i keygened)
+{
+    keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3, 3, 3, 3));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+
+    return _mm_xor_si128(key, keygened);
+}
+
+__attribute__((target("aes")))
+static void aes128_expand(uint8_t out[11][16], const uint8_t key[16])
+{
+    __m128i rk[11];
+
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    AES128_EXPAND(rk, 1, 0x01);
+    AES128_EXPAND(rk, 2, 0x02);
+    AES128_EXPAND(rk, 3, 0x04);
+    AES128_EXPAND(rk, 4, 0x08);
+    AES128_EXPAND(rk, 5, 0x10);
+    AES128_EXPAND(rk, 6, 0x20);
+    AES128_EXPAND(rk, 7, 0x40);
+    AES128_EXPAND(rk, 8, 0x80);
+    AES128_EXPAND(rk, 9, 0x1b);
+    AES128_EXPAND(rk, 10, 0x36);
+
+    for (size_t i = 0; i < 11; i++)
+    {
+        _mm_store_si128((__m128i *)out[i], rk[i]);
+    }
+}
+
+// encrypt 8 consecutive counter blocks, interleaved to hide the aesenc latency
+__attribute__((target("aes")))
+static void aes128_ctr8(const uint8_t rk[11][16], uint64_t ctr, uint8_t out[128])
+{
+    __m128i x[8];
+    __m128i k = _mm_load_si128((const __m128i *)rk[0]);
+
+    for (size_t j = 0; j < 8; j++)
+    {
+        x[j] = _mm_xor_si128(_mm_set_epi64x(0, ctr + j), k);
+    }
+
+    for (size_t i = 1; i < 10; i++)
+    {
+        k = _mm_load_si128((const __m128i *)rk[i]);
+
+        for (size_t j = 0; j < 8; j++)
+        {
+            x[j] = _mm_aesenc_si128(x[j], k);
+        }
+    }
+
+    k = _mm_load_si128((const __m128i *)rk[10]);
+
+    for (size_t j = 0; j < 8; j++)
+    {
+        _mm_storeu_si128((__m128i *)&out[16 * j], _mm_aesenclast_si128(x[j], k));
+    }
+}
+
+__attribute__((target("aes")))
+static void aes128_ctr1(const uint8_t rk[11][16], uint64_t ctr, uint8_t out[16])
+{
+    __m128i x = _mm_xor_si128(_mm_set_epi64x(0, ctr), _mm_load_si128((const __m128i *)rk[0]));
+
+    for (size_t i = 1; i < 10; i++)
+    {
+        x = _mm_aesenc_si128(x, _mm_load_si128((const __m128i *)rk[i]));
+    }
+
+    _mm_storeu_si128((__m128i *)out, _mm_aesenclast_si128(x, _mm_load_si128((const __m128i *)rk[10])));
+}
+
+int aesctr_rng_available()
+{
+    return __builtin_cpu_supports("aes");
+}
+
+void aesctr_rng_init(struct aesctr_rng *ctx, const uint8_t seed[16])
+{
+    aes128_expand(ctx->rk, seed);
+    ctx->ctr = 0;
+    ctx->pos = sizeof(ctx->buf);
+}
+
+void aesctr_rng_generate(struct aesctr_rng *ctx, uint8_t *out, size_t len)
+{
+    // leftover keystream from a previous call
+    while (len > 0 && ctx->pos < sizeof(ctx->buf))
+    {
+        *out++ = ctx->buf[ctx->pos++];
+        len--;
+    }
+
+    for (; len >= 128; len -= 128, out += 128)
+    {
+        aes128_ctr8((const uint8_t (*)[16])ctx->rk, ctx->ctr, out);
+        ctx->ctr += 8;
+    }
+
+    for (; len >= 16; len -= 16, out += 16)
+    {
+        aes128_ctr1((const uint8_t (*)[16])ctx->rk, ctx->ctr++, out);
+    }
+
+    if (len > 0)
+    {
+        aes128_ctr1((const uint8_t (*)[16])ctx->rk, ctx->ctr++, ctx->buf);
+        memcpy(out, ctx->buf, len);
+        ctx->pos = len;
+    }
+}
+
+#else
+
+int aesctr_rng_available()
+{
+    return 0;
+}
+
+void aesctr_rng_init(__attribute__((unused)) struct aesctr_rng *ctx, __attribute__((unused)) const uint8_t seed[16])
+{
+}
+
+void aesctr_rng_generate(__attribute__((unused)) struct aesctr_rng *ctx, __attribute__((unused)) uint8_t *out, __attribute__((unused)) size_t len)
+{
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AESCTR_H
+#define AESCTR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// AES-128 in counter mode used as host CSPRNG, requires AES-NI
+struct aesctr_rng
+{
+    uint8_t rk[11][16] __attribute__((aligned(16)));
+    uint64_t ctr;
+    uint8_t buf[16];
+    size_t pos;
+};
+
+int aesctr_rng_available(void);
+void aesctr_rng_init(struct aesctr_rng *ctx, const uint8_t seed[16]);
+void aesctr_rng_generate(struct aesctr_rng *ctx, uint8_t *out, size_t len);
+
+#endif // AESCTR_H
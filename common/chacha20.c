@@ -0,0 +1,279 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "chacha20.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHACHA20_X86
+#endif
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d)                  \
+    a += b; d ^= a; d = ROTL32(d, 16);            \
+    c += d; b ^= c; b = ROTL32(b, 12);            \
+    a += b; d ^= a; d = ROTL32(d, 8);             \
+    c += d; b ^= c; b = ROTL32(b, 7)
+
+static void store32_le(uint8_t *out, uint32_t x)
+{
+    out[0] = x;
+    out[1] = x >> 8;
+    out[2] = x >> 16;
+    out[3] = x >> 24;
+}
+
+static uint32_t load32_le(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void chacha20_counter_add(uint32_t state[16], uint64_t n)
+{
+    uint64_t ctr = ((uint64_t)state[13] << 32 | state[12]) + n;
+
+    state[12] = ctr;
+    state[13] = ctr >> 32;
+}
+
+// [https://www.rfc-editor.org/rfc/rfc8439, Section 2.3]
+static void chacha20_block(uint32_t state[16], uint8_t out[64])
+{
+    uint32_t x[16];
+
+    memcpy(x, state, sizeof(x));
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        QUARTERROUND(x[0], x[4], x[8], x[12]);
+        QUARTERROUND(x[1], x[5], x[9], x[13]);
+        QUARTERROUND(x[2], x[6], x[10], x[14]);
+        QUARTERROUND(x[3], x[7], x[11], x[15]);
+        QUARTERROUND(x[0], x[5], x[10], x[15]);
+        QUARTERROUND(x[1], x[6], x[11], x[12]);
+        QUARTERROUND(x[2], x[7], x[8], x[13]);
+        QUARTERROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (size_t i = 0; i < 16; i++)
+    {
+        store32_le(&out[4 * i], x[i] + state[i]);
+    }
+
+    chacha20_counter_add(state, 1);
+}
+
+#ifdef CHACHA20_X86
+
+/*
+* Block-parallel kernels: every vector register holds the same state word of
+* 4 (SSE2) or 8 (AVX2) consecutive blocks, which are transposed back to the
+* serial keystream layout on output.
+*/
+
+#define ROTL128(x, n) _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - (n)))
+
+#define QUARTERROUND128(a, b, c, d)                                             \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ROTL128(d, 16);       \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ROTL128(b, 12);       \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ROTL128(d, 8);        \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ROTL128(b, 7)
+
+static void chacha20_block4_sse2(uint32_t state[16], uint8_t out[256])
+{
+    __m128i x[16], s[16];
+
+    for (size_t i = 0; i < 16; i++)
+    {
+        s[i] = _mm_set1_epi32(state[i]);
+    }
+
+    uint64_t ctr = (uint64_t)state[13] << 32 | state[12];
+    s[12] = _mm_set_epi32(ctr + 3, ctr + 2, ctr + 1, ctr);
+    s[13] = _mm_set_epi32((ctr + 3) >> 32, (ctr + 2) >> 32, (ctr + 1) >> 32, ctr >> 32);
+
+    memcpy(x, s, sizeof(x));
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        QUARTERROUND128(x[0], x[4], x[8], x[12]);
+        QUARTERROUND128(x[1], x[5], x[9], x[13]);
+        QUARTERROUND128(x[2], x[6], x[10], x[14]);
+        QUARTERROUND128(x[3], x[7], x[11], x[15]);
+        QUARTERROUND128(x[0], x[5], x[10], x[15]);
+        QUARTERROUND128(x[1], x[6], x[11], x[12]);
+        QUARTERROUND128(x[2], x[7], x[8], x[13]);
+        QUARTERROUND128(x[3], x[4], x[9], x[14]);
+    }
+
+    for (size_t i = 0; i < 16; i += 4)
+    {
+        __m128i a = _mm_add_epi32(x[i], s[i]);
+        __m128i b = _mm_add_epi32(x[i + 1], s[i + 1]);
+        __m128i c = _mm_add_epi32(x[i + 2], s[i + 2]);
+        __m128i d = _mm_add_epi32(x[i + 3], s[i + 3]);
+
+        // 4x4 transpose: words i..i+3 of blocks 0..3
+        __m128i t0 = _mm_unpacklo_epi32(a, b);
+        __m128i t1 = _mm_unpacklo_epi32(c, d);
+        __m128i t2 = _mm_unpackhi_epi32(a, b);
+        __m128i t3 = _mm_unpackhi_epi32(c, d);
+
+        _mm_storeu_si128((__m128i *)&out[0 * 64 + 4 * i], _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)&out[1 * 64 + 4 * i], _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)&out[2 * 64 + 4 * i], _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128((__m128i *)&out[3 * 64 + 4 * i], _mm_unpackhi_epi64(t2, t3));
+    }
+
+    chacha20_counter_add(state, 4);
+}
+
+#define ROTL256(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+
+#define QUARTERROUND256(a, b, c, d)                                                     \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = ROTL256(d, 16);         \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL256(b, 12);         \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = ROTL256(d, 8);          \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL256(b, 7)
+
+__attribute__((target("avx2")))
+static void chacha20_block8_avx2(uint32_t state[16], uint8_t out[512])
+{
+    __m256i x[16], s[16];
+
+    for (size_t i = 0; i < 16; i++)
+    {
+        s[i] = _mm256_set1_epi32(state[i]);
+    }
+
+    uint64_t ctr = (uint64_t)state[13] << 32 | state[12];
+    s[12] = _mm256_set_epi32(ctr + 7, ctr + 6, ctr + 5, ctr + 4, ctr + 3, ctr + 2, ctr + 1, ctr);
+    s[13] = _mm256_set_epi32((ctr + 7) >> 32, (ctr + 6) >> 32, (ctr + 5) >> 32, (ctr + 4) >> 32,
+                             (ctr + 3) >> 32, (ctr + 2) >> 32, (ctr + 1) >> 32, ctr >> 32);
+
+    memcpy(x, s, sizeof(x));
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        QUARTERROUND256(x[0], x[4], x[8], x[12]);
+        QUARTERROUND256(x[1], x[5], x[9], x[13]);
+        QUARTERROUND256(x[2], x[6], x[10], x[14]);
+        QUARTERROUND256(x[3], x[7], x[11], x[15]);
+        QUARTERROUND256(x[0], x[5], x[10], x[15]);
+        QUARTERROUND256(x[1], x[6], x[11], x[12]);
+        QUARTERROUND256(x[2], x[7], x[8], x[13]);
+        QUARTERROUND256(x[3], x[4], x[9], x[14]);
+    }
+
+    for (size_t i = 0; i < 16; i += 4)
+    {
+        __m256i a = _mm256_add_epi32(x[i], s[i]);
+        __m256i b = _mm256_add_epi32(x[i + 1], s[i + 1]);
+        __m256i c = _mm256_add_epi32(x[i + 2], s[i + 2]);
+        __m256i d = _mm256_add_epi32(x[i + 3], s[i + 3]);
+
+        // 4x4 transpose within each 128-bit half: blocks 0..3 low, blocks 4..7 high
+        __m256i t0 = _mm256_unpacklo_epi32(a, b);
+        __m256i t1 = _mm256_unpacklo_epi32(c, d);
+        __m256i t2 = _mm256_unpackhi_epi32(a, b);
+        __m256i t3 = _mm256_unpackhi_epi32(c, d);
+        __m256i o[4];
+
+        o[0] = _mm256_unpacklo_epi64(t0, t1);
+        o[1] = _mm256_unpackhi_epi64(t0, t1);
+        o[2] = _mm256_unpacklo_epi64(t2, t3);
+        o[3] = _mm256_unpackhi_epi64(t2, t3);
+
+        for (size_t j = 0; j < 4; j++)
+        {
+            _mm_storeu_si128((__m128i *)&out[j * 64 + 4 * i], _mm256_castsi256_si128(o[j]));
+            _mm_storeu_si128((__m128i *)&out[(j + 4) * 64 + 4 * i], _mm256_extracti128_si256(o[j], 1));
+        }
+    }
+
+    chacha20_counter_add(state, 8);
+}
+
+#endif // CHACHA20_X86
+
+void chacha20_rng_init(struct chacha20_rng *ctx, const uint8_t seed[32])
+{
+    // "expand 32-byte k"
+    ctx->state[0] = 0x61707865;
+    ctx->state[1] = 0x3320646e;
+    ctx->state[2] = 0x79622d32;
+    ctx->state[3] = 0x6b206574;
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        ctx->state[4 + i] = load32_le(&seed[4 * i]);
+    }
+
+    for (size_t i = 12; i < 16; i++)
+    {
+        ctx->state[i] = 0;
+    }
+
+    ctx->pos = sizeof(ctx->buf);
+}
+
+void chacha20_rng_generate(struct chacha20_rng *ctx, uint8_t *out, size_t len)
+{
+    // leftover keystream from a previous call
+    while (len > 0 && ctx->pos < sizeof(ctx->buf))
+    {
+        *out++ = ctx->buf[ctx->pos++];
+        len--;
+    }
+
+#ifdef CHACHA20_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        for (; len >= 512; len -= 512, out += 512)
+        {
+            chacha20_block8_avx2(ctx->state, out);
+        }
+    }
+
+    for (; len >= 256; len -= 256, out += 256)
+    {
+        chacha20_block4_sse2(ctx->state, out);
+    }
+#endif
+
+    for (; len >= 64; len -= 64, out += 64)
+    {
+        chacha20_block(ctx->state, out);
+    }
+
+    if (len > 0)
+    {
+        chacha20_block(ctx->state, ctx->buf);
+        memcpy(out, ctx->buf, len);
+        ctx->pos = len;
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ChaCha20 keystream generator (64-bit block counter, zero nonce) used as host CSPRNG
+struct chacha20_rng
+{
+    uint32_t state[16];
+    uint8_t buf[64];
+    size_t pos;
+};
+
+void chacha20_rng_init(struct chacha20_rng *ctx, const uint8_t seed[32]);
+void chacha20_rng_generate(struct chacha20_rng *ctx, uint8_t *out, size_t len);
+
+#endif // CHACHA20_H
@@ -49,39 +49,45 @@
     void hal_send_str(const char* in);
     uint64_t hal_get_time(void);
     void printcycles(const char *s, uint64_t c);
-
-    #if defined(PROFILE_STEP_CYCLES)
-        #undef PROFILE_STEP_INIT
-        #undef PROFILE_STEP_START
-        #undef PROFILE_STEP_STOP
-        #define PROFILE_STEP_INIT() uint64_t t0, t1
-        #define PROFILE_STEP_START() t0 = hal_get_time()
-        #define PROFILE_STEP_STOP(step) t1 = hal_get_time(); \
-                printcycles("Step " #step " cycles:", t1 - t0)
-    #elif defined(PROFILE_STEP_RAND)
-        #undef PROFILE_STEP_INIT 
-        #undef PROFILE_STEP_START
-        #undef PROFILE_STEP_STOP
-        #define PROFILE_STEP_INIT() do{}while(0)
-        #define PROFILE_STEP_START() nb_randombytes = 0
-        #define PROFILE_STEP_STOP(step) printcycles("Step " #step " randombytes:", nb_randombytes)
-    #else
-        #undef PROFILE_TOP_INIT 
-        #undef PROFILE_TOP_START 
-        #undef PROFILE_TOP_STOP
-        #if defined(PROFILE_TOP_RAND)
-            #define PROFILE_TOP_INIT() do{}while(0)
-            #define PROFILE_TOP_START() nb_randombytes = 0
-            #define PROFILE_TOP_STOP() printcycles("MaskedComparison randombytes:", nb_randombytes)
-        #else // PROFILE_TOP_CYCLES
-            #define PROFILE_TOP_INIT() uint64_t t0, t1
-            #define PROFILE_TOP_START() t0 = hal_get_time()
-            #define PROFILE_TOP_STOP() t1 = hal_get_time(); \
-                    printcycles("MaskedComparison cycles:", t1 - t0)
-        #endif
-    #endif
 #endif // DEBUG
 
+// randomness profiling also works on the host, cycle profiling is ARM only
+#if defined(PROFILE_STEP_CYCLES) && !defined(DEBUG)
+    #undef PROFILE_STEP_INIT
+    #undef PROFILE_STEP_START
+    #undef PROFILE_STEP_STOP
+    #define PROFILE_STEP_INIT() uint64_t t0, t1
+    #define PROFILE_STEP_START() t0 = hal_get_time()
+    #define PROFILE_STEP_STOP(step) t1 = hal_get_time(); \
+            printcycles("Step " #step " cycles:", t1 - t0)
+#elif defined(PROFILE_STEP_RAND)
+    #include "randombytes.h"
+    #undef PROFILE_STEP_INIT 
+    #undef PROFILE_STEP_START
+    #undef PROFILE_STEP_STOP
+    #define PROFILE_STEP_INIT() do{}while(0)
+    #define PROFILE_STEP_START() rng_stats_reset()
+    #define PROFILE_STEP_STOP(step) printcycles("Step " #step " randombytes:", rng_stats_bytes()); \
+            rng_stats_report(__func__, "step" #step)
+#elif defined(PROFILE_TOP_RAND)
+    #include "randombytes.h"
+    #undef PROFILE_TOP_INIT 
+    #undef PROFILE_TOP_START 
+    #undef PROFILE_TOP_STOP
+    #define PROFILE_TOP_INIT() do{}while(0)
+    #define PROFILE_TOP_START() rng_stats_reset()
+    #define PROFILE_TOP_STOP() printcycles("MaskedComparison randombytes:", rng_stats_bytes()); \
+            rng_stats_report("MaskedComparison", "top")
+#elif !defined(DEBUG) // PROFILE_TOP_CYCLES
+    #undef PROFILE_TOP_INIT 
+    #undef PROFILE_TOP_START 
+    #undef PROFILE_TOP_STOP
+    #define PROFILE_TOP_INIT() uint64_t t0, t1
+    #define PROFILE_TOP_START() t0 = hal_get_time()
+    #define PROFILE_TOP_STOP() t1 = hal_get_time(); \
+            printcycles("MaskedComparison cycles:", t1 - t0)
+#endif
+
 
 
 #endif
@@ -2,32 +2,110 @@
 // Copyright unclear.
 #include "randombytes.h"
 
+#include <string.h>
+
+#if defined(DEBUG) && !defined(RNG_XORSHIFT)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Host CSPRNG: a ChaCha20 keystream, or AES-CTR with RNG_AESCTR when AES-NI is
+// present. Every thread keys its own context, from the OS entropy source unless
+// rng_ctx_seed() was called first.
+RNG_THREAD_LOCAL struct rng_ctx rng_ctx;
+
+static void rng_os_seed(uint8_t *seed, size_t len)
+{
+    FILE *f = fopen("/dev/urandom", "rb");
+
+    if (f == NULL || fread(seed, 1, len, f) != len)
+    {
+        fprintf(stderr, "randombytes: cannot read /dev/urandom\n");
+        abort();
+    }
+
+    fclose(f);
+}
+
+static void rng_backend_seed(const uint8_t seed[32])
+{
+#ifdef RNG_AESCTR
+    rng_ctx.aesctr_enabled = aesctr_rng_available();
+    if (rng_ctx.aesctr_enabled)
+    {
+        aesctr_rng_init(&rng_ctx.aesctr, seed);
+    }
+    else
+#endif
+    {
+        chacha20_rng_init(&rng_ctx.chacha20, seed);
+    }
+
+    rng_ctx.seeded = 1;
+}
+
+int randombytes(uint8_t *obuf, size_t len)
+{
+    if (!rng_ctx.seeded)
+    {
+        uint8_t seed[32];
+
+        rng_os_seed(seed, sizeof(seed));
+        rng_backend_seed(seed);
+    }
+
+#ifdef RNG_AESCTR
+    if (rng_ctx.aesctr_enabled)
+    {
+        aesctr_rng_generate(&rng_ctx.aesctr, obuf, len);
+        return 0;
+    }
+#endif
+
+    chacha20_rng_generate(&rng_ctx.chacha20, obuf, len);
+
+    return 0;
+}
+
+#else
+
 // Use fully deterministic randomness, using an insecure PRNG from a fixed
 // seed.  This is only meant for debugging purposes.
-struct {
-    uint32_t a, b, c, d;
-} xorshift128_state = {
-    .a = 0x12345678,
-    .b = 0xAAAAAAA1,
-    .c = 0xAAAAAAA2,
-    .d = 0xAAAAAAA3,
+RNG_THREAD_LOCAL struct rng_ctx rng_ctx = {
+    .xorshift128 = {
+        .a = 0x12345678,
+        .b = 0xAAAAAAA1,
+        .c = 0xAAAAAAA2,
+        .d = 0xAAAAAAA3,
+    },
 };
 
+static void rng_backend_seed(const uint8_t seed[32])
+{
+    rng_ctx.xorshift128.a = (uint32_t)seed[0] | (uint32_t)seed[1] << 8 | (uint32_t)seed[2] << 16 | (uint32_t)seed[3] << 24;
+    rng_ctx.xorshift128.b = (uint32_t)seed[4] | (uint32_t)seed[5] << 8 | (uint32_t)seed[6] << 16 | (uint32_t)seed[7] << 24;
+    rng_ctx.xorshift128.c = (uint32_t)seed[8] | (uint32_t)seed[9] << 8 | (uint32_t)seed[10] << 16 | (uint32_t)seed[11] << 24;
+    rng_ctx.xorshift128.d = (uint32_t)seed[12] | (uint32_t)seed[13] << 8 | (uint32_t)seed[14] << 16 | (uint32_t)seed[15] << 24;
+
+    // the all-zero state is a fixed point
+    rng_ctx.xorshift128.a |= 1;
+}
+
 static int xorshift128(void)
 {
 	// Algorithm "xor128" from p. 5 of Marsaglia, "Xorshift RNGs"
     // This version is taken from Wikipedia.
-	uint32_t t = xorshift128_state.d;
+	uint32_t t = rng_ctx.xorshift128.d;
 
-	uint32_t const s = xorshift128_state.a;
-	xorshift128_state.d = xorshift128_state.c;
-	xorshift128_state.c = xorshift128_state.b;
-	xorshift128_state.b = s;
+	uint32_t const s = rng_ctx.xorshift128.a;
+	rng_ctx.xorshift128.d = rng_ctx.xorshift128.c;
+	rng_ctx.xorshift128.c = rng_ctx.xorshift128.b;
+	rng_ctx.xorshift128.b = s;
 
 	t ^= t << 11;
 	t ^= t >> 8;
-    xorshift128_state.a = t ^ s ^ (s >> 19);
-    return (int)xorshift128_state.a;
+    rng_ctx.xorshift128.a = t ^ s ^ (s >> 19);
+    return (int)rng_ctx.xorshift128.a;
 }
 
 int randombytes(uint8_t *obuf, size_t len)
@@ -58,6 +136,8 @@ int randombytes(uint8_t *obuf, size_t len)
     return 0;
 }
 
+#endif
+
 #ifdef DEBUG
 
 uint32_t rng_get_random_blocking()
@@ -71,15 +151,213 @@ uint32_t rng_get_random_blocking()
 
 #endif // DEBUG
 
+#if defined(RNG_TAPE) || !defined(RNG_DIRECT)
+
+static void rng_fill(uint32_t *buf, size_t len)
+{
+#ifdef DEBUG
+    randombytes((uint8_t *)buf, len * sizeof(uint32_t));
+#else
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = rng_get_random_blocking();
+    }
+#endif
+}
+
+#endif
+
+#if defined(RNG_TAPE)
+
+// offline phase: can run ahead of time, e.g. while idle or on another core
+void rng_tape_fill(uint32_t *tape, size_t len)
+{
+    rng_fill(tape, len);
+}
+
+// online phase: all subsequent random words are read from the tape
+void rng_tape_attach(const uint32_t *tape, size_t len)
+{
+    rng_ctx.tape.buf = tape;
+    rng_ctx.tape.len = len;
+    rng_ctx.tape.pos = 0;
+}
+
+#elif !defined(RNG_DIRECT)
+
+// top up the ring buffer: everything from the write position up to the read position
+void rng_pool_refill()
+{
+    struct rng_pool_t *pool = &rng_ctx.pool;
+    size_t tail = (pool->head + pool->avail) & (RNG_POOL_SIZE - 1);
+    size_t len = RNG_POOL_SIZE - pool->avail;
+
+    if (tail + len > RNG_POOL_SIZE)
+    {
+        rng_fill(&pool->buf[tail], RNG_POOL_SIZE - tail);
+        rng_fill(&pool->buf[0], tail + len - RNG_POOL_SIZE);
+    }
+    else
+    {
+        rng_fill(&pool->buf[tail], len);
+    }
+
+    pool->avail = RNG_POOL_SIZE;
+}
+
+#endif
+
+// bulk request: same words, in the same order, as len calls to rng_get_random()
+void rng_get_random_words(uint32_t *out, size_t len)
+{
+#if defined(RNG_TAPE)
+#ifdef DEBUG
+    assert(rng_ctx.tape.len - rng_ctx.tape.pos >= len);
+#endif
+    memcpy(out, &rng_ctx.tape.buf[rng_ctx.tape.pos], len * sizeof(uint32_t));
+    rng_ctx.tape.pos += len;
+#elif !defined(RNG_DIRECT)
+    struct rng_pool_t *pool = &rng_ctx.pool;
+
+    while (len > 0)
+    {
+        if (pool->avail <= RNG_POOL_WATERMARK)
+        {
+            rng_pool_refill();
+        }
+
+        // contiguous words up to the watermark or the end of the ring
+        size_t n = pool->avail - RNG_POOL_WATERMARK;
+        if (n > RNG_POOL_SIZE - pool->head)
+        {
+            n = RNG_POOL_SIZE - pool->head;
+        }
+        if (n > len)
+        {
+            n = len;
+        }
+
+        memcpy(out, &pool->buf[pool->head], n * sizeof(uint32_t));
+        pool->head = (pool->head + n) & (RNG_POOL_SIZE - 1);
+        pool->avail -= n;
+        out += n;
+        len -= n;
+    }
+#else
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = rng_get_random_blocking();
+    }
+#endif
+}
+
+void random_uint64_n(uint64_t *out, size_t len)
+{
+    uint32_t buf[64];
+
+    while (len > 0)
+    {
+        size_t n = (len < 32) ? len : 32;
+
+        random_uint32_n(buf, 2 * n);
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = ((uint64_t)buf[2 * i]) | ((uint64_t)buf[2 * i + 1]) << 32;
+        }
+
+        out += n;
+        len -= n;
+    }
+}
+
+void rng_ctx_seed(const uint8_t seed[32])
+{
+    rng_backend_seed(seed);
+
+#if defined(RNG_TAPE)
+    rng_ctx.tape.len = 0;
+    rng_ctx.tape.pos = 0;
+#elif !defined(RNG_DIRECT)
+    rng_ctx.pool.avail = 0;
+#endif
+}
+
 #if defined(PROFILE_STEP_RAND) || defined(PROFILE_TOP_RAND)
 
-uint64_t nb_randombytes;
+#include "hal.h"
+
+static const char *rng_gadget_names[RNG_NGADGETS] = {
+    [RNG_GADGET_OTHER] = "other",
+    [RNG_GADGET_SECAND32] = "SecAND32",
+    [RNG_GADGET_SECAND64] = "SecAND64",
+    [RNG_GADGET_SECAND_LANE] = "SecAND_lane",
+    [RNG_GADGET_REFRESHXOR] = "RefreshXOR",
+    [RNG_GADGET_REFRESHXOR32] = "RefreshXOR32",
+    [RNG_GADGET_REFRESHXOR_LANE] = "RefreshXOR_lane",
+    [RNG_GADGET_REFRESHXOR_BITSLICED] = "RefreshXOR_bitsliced",
+    [RNG_GADGET_B2A_REFRESH] = "B2A_refresh",
+    [RNG_GADGET_B2A] = "B2A",
+    [RNG_GADGET_SECLUT] = "SecLUT",
+    [RNG_GADGET_RANDOMQ] = "randomq",
+    [RNG_GADGET_REDUCECOMPARISONS] = "ReduceComparisons",
+    [RNG_GADGET_REDUCECOMPARISONS_GF] = "ReduceComparisons_GF",
+};
+
+void rng_stats_reset()
+{
+    for (size_t i = 0; i < RNG_NGADGETS; i++)
+    {
+        rng_ctx.stats[i].calls = 0;
+        rng_ctx.stats[i].bytes = 0;
+    }
+
+    rng_ctx.gadget = RNG_GADGET_OTHER;
+}
+
+uint64_t rng_stats_bytes()
+{
+    uint64_t bytes = 0;
+
+    for (size_t i = 0; i < RNG_NGADGETS; i++)
+    {
+        bytes += rng_ctx.stats[i].bytes;
+    }
+
+    return bytes;
+}
+
+void rng_stats_report(const char *method, const char *scope)
+{
+    char outs[128];
+
+    for (size_t i = 0; i < RNG_NGADGETS; i++)
+    {
+        if (rng_ctx.stats[i].calls == 0 && rng_ctx.stats[i].bytes == 0)
+        {
+            continue;
+        }
+
+        snprintf(outs, sizeof(outs), "randstats,%s,%s,%s,%lu,%lu", method, scope, rng_gadget_names[i],
+                 (long unsigned)rng_ctx.stats[i].calls, (long unsigned)rng_ctx.stats[i].bytes);
+        hal_send_str(outs);
+    }
+
+    snprintf(outs, sizeof(outs), "randstats,%s,%s,total,,%lu", method, scope, (long unsigned)rng_stats_bytes());
+    hal_send_str(outs);
+}
+
+void rng_count_get_random_words(uint32_t *out, size_t len)
+{
+    rng_ctx.stats[rng_ctx.gadget].bytes += 4 * len;
+
+    rng_get_random_words(out, len);
+}
 
 uint32_t rng_count_get_random_blocking()
 {
-	nb_randombytes += 4; 
+    rng_ctx.stats[rng_ctx.gadget].bytes += 4;
 
-    return rng_get_random_blocking();
+    return rng_get_random();
 }
 
 #endif 
\ No newline at end of file
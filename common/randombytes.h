@@ -35,18 +35,195 @@ uint32_t rng_get_random_blocking(void);
 #include <libopencm3/stm32/rng.h>
 #endif
 
-// fully deterministic randomness
+// host: ChaCha20 or AES-CTR CSPRNG seeded from the OS, fully deterministic xorshift128 otherwise
 int randombytes(uint8_t *obuf, size_t len);
 
+// per-thread rng context: host builds may run comparisons on several threads
+#ifndef RNG_THREAD_LOCAL
+    #ifdef DEBUG
+        #define RNG_THREAD_LOCAL __thread
+    #else
+        #define RNG_THREAD_LOCAL
+    #endif
+#endif
+
+#if defined(DEBUG) && !defined(RNG_XORSHIFT)
+    #include "chacha20.h"
+    #include "aesctr.h"
+#endif
+
+// randomness tape: all randomness of a comparison is drawn offline, the online phase only reads it back
+#if defined(RNG_TAPE)
+
+    #ifdef DEBUG
+    #include <assert.h>
+    #endif
+
+    struct rng_tape_t
+    {
+        const uint32_t *buf;
+        size_t len;
+        size_t pos;
+    };
+
+// randomness pool: a ring buffer that is refilled from the trng in bulk
+#elif !defined(RNG_DIRECT)
+
+    #ifndef RNG_POOL_SIZE
+        #define RNG_POOL_SIZE 256 // in words, must be a power of two
+    #endif
+
+    #ifndef RNG_POOL_WATERMARK
+        #define RNG_POOL_WATERMARK 0 // refill as soon as no more than this many words are left
+    #endif
+
+    #if (RNG_POOL_SIZE & (RNG_POOL_SIZE - 1)) != 0
+        #error "RNG_POOL_SIZE must be a power of two"
+    #endif
+
+    #if RNG_POOL_WATERMARK >= RNG_POOL_SIZE
+        #error "RNG_POOL_WATERMARK must be smaller than RNG_POOL_SIZE"
+    #endif
+
+    struct rng_pool_t
+    {
+        uint32_t buf[RNG_POOL_SIZE] __attribute__((aligned(64)));
+        size_t head;
+        size_t avail;
+    };
+
+#endif
+
+// randomness accounting: every gadget that draws randomness tags itself before drawing and restores the caller's tag when done
+enum rng_gadget
+{
+    RNG_GADGET_OTHER,
+    RNG_GADGET_SECAND32,
+    RNG_GADGET_SECAND64,
+    RNG_GADGET_SECAND_LANE,
+    RNG_GADGET_REFRESHXOR,
+    RNG_GADGET_REFRESHXOR32,
+    RNG_GADGET_REFRESHXOR_LANE,
+    RNG_GADGET_REFRESHXOR_BITSLICED,
+    RNG_GADGET_B2A_REFRESH,
+    RNG_GADGET_B2A,
+    RNG_GADGET_SECLUT,
+    RNG_GADGET_RANDOMQ,
+    RNG_GADGET_REDUCECOMPARISONS,
+    RNG_GADGET_REDUCECOMPARISONS_GF,
+    RNG_NGADGETS
+};
+
+struct rng_gadget_stats
+{
+    uint64_t calls;
+    uint64_t bytes;
+};
+
+// all mutable rng state, one instance per thread
+struct rng_ctx
+{
+#if defined(DEBUG) && !defined(RNG_XORSHIFT)
+    struct chacha20_rng chacha20;
+#ifdef RNG_AESCTR
+    struct aesctr_rng aesctr;
+    int aesctr_enabled;
+#endif
+    int seeded;
+#else
+    struct
+    {
+        uint32_t a, b, c, d;
+    } xorshift128;
+#endif
+
+#if defined(RNG_TAPE)
+    struct rng_tape_t tape;
+#elif !defined(RNG_DIRECT)
+    struct rng_pool_t pool;
+#endif
+
+#if defined(PROFILE_STEP_RAND) || defined(PROFILE_TOP_RAND)
+    enum rng_gadget gadget;
+    struct rng_gadget_stats stats[RNG_NGADGETS];
+#endif
+};
+
+extern RNG_THREAD_LOCAL struct rng_ctx rng_ctx;
+
+// (re)seed the calling thread's context, buffered words are discarded
+// ARM: the trng needs no seed, only the buffered words are discarded
+void rng_ctx_seed(const uint8_t seed[32]);
+
+#if defined(RNG_TAPE)
+
+    void rng_tape_fill(uint32_t *tape, size_t len);
+    void rng_tape_attach(const uint32_t *tape, size_t len);
+
+    static inline uint32_t rng_tape_get_random(void)
+    {
+    #ifdef DEBUG
+        assert(rng_ctx.tape.pos < rng_ctx.tape.len);
+    #endif
+
+        return rng_ctx.tape.buf[rng_ctx.tape.pos++];
+    }
+
+    #define rng_get_random() (rng_tape_get_random())
+
+#elif !defined(RNG_DIRECT)
+
+    void rng_pool_refill(void);
+
+    static inline uint32_t rng_pool_get_random(void)
+    {
+        struct rng_pool_t *pool = &rng_ctx.pool;
+
+        if (pool->avail <= RNG_POOL_WATERMARK)
+        {
+            rng_pool_refill();
+        }
+
+        uint32_t R = pool->buf[pool->head];
+        pool->head = (pool->head + 1) & (RNG_POOL_SIZE - 1);
+        pool->avail--;
+
+        return R;
+    }
+
+    #define rng_get_random() (rng_pool_get_random())
+#else
+    #define rng_get_random() (rng_get_random_blocking())
+#endif
+
+void rng_get_random_words(uint32_t *out, size_t len);
+
 // trng
 #if defined(PROFILE_STEP_RAND) || defined(PROFILE_TOP_RAND)
-    extern uint64_t nb_randombytes;
+    void rng_stats_reset(void);
+    uint64_t rng_stats_bytes(void);
+    // one line per gadget: randstats,<method>,<scope>,<gadget>,<calls>,<bytes>
+    void rng_stats_report(const char *method, const char *scope);
+
+    // PROFILE_RAND_GADGET saves the current tag in a local of the enclosing block, PROFILE_RAND_GADGET_END restores it
+    #define PROFILE_RAND_GADGET(id) enum rng_gadget rng_gadget_saved = rng_ctx.gadget; rng_ctx.gadget = (id); rng_ctx.stats[id].calls++
+    #define PROFILE_RAND_GADGET_END() do{ rng_ctx.gadget = rng_gadget_saved; }while(0)
+
     uint32_t rng_count_get_random_blocking(void);
+    void rng_count_get_random_words(uint32_t *out, size_t len);
     #define random_uint32() (rng_count_get_random_blocking())                 
     #define random_uint64() (((uint64_t)rng_count_get_random_blocking()) | ((uint64_t)rng_count_get_random_blocking()) << 32)
+    #define random_uint32_n(out, len) (rng_count_get_random_words(out, len))
 #else
-    #define random_uint32() (rng_get_random_blocking())
-    #define random_uint64() (((uint64_t)rng_get_random_blocking()) | ((uint64_t)rng_get_random_blocking()) << 32)
+    #define PROFILE_RAND_GADGET(id) do{}while(0)
+    #define PROFILE_RAND_GADGET_END() do{}while(0)
+
+    #define random_uint32() (rng_get_random())
+    #define random_uint64() (((uint64_t)rng_get_random()) | ((uint64_t)rng_get_random()) << 32)
+    #define random_uint32_n(out, len) (rng_get_random_words(out, len))
 #endif
 
+// len random words in one bulk request
+void random_uint64_n(uint64_t *out, size_t len);
+
 #endif /* RANDOMBYTES_H */
\ No newline at end of file
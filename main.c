@@ -24,6 +24,14 @@
  * SOFTWARE.
  */
 #include "MaskedComparison.h"
+#include "SecAnd.h"
+#include "SecAdd.h"
+#include "A2B.h"
+#include "Transpose.h"
+#include "A2BTable.h"
+#include "ReduceComparisons.h"
+#include "BooleanEqualityTest.h"
+#include "Clmul.h"
 #include "randombytes.h"
 #include "params.h"
 #include "hal.h"
@@ -33,11 +41,72 @@
 #include <stddef.h>
 #include <assert.h>
 
+// test vectors and errors do not come from the randomness tape
+#ifdef RNG_TAPE
+    #define test_random_uint32() (rng_get_random_blocking())
+#else
+    #define test_random_uint32() (random_uint32())
+#endif
+
+#ifdef RNG_TAPE
+
+#ifdef HYBRIDSIMPLE
+    #error "RNG_TAPE: HYBRIDSIMPLE has a data-dependent number of random words"
+#endif
+
+#ifndef RNG_TAPE_WORDS
+    #define RNG_TAPE_WORDS (1 << 20) // in words, enough for all configurations with NSHARES <= 5
+#endif
+
+static uint32_t tape[RNG_TAPE_WORDS];
+
+static size_t comparison_rand_words(void)
+{
+#if defined(ARITH)
+    return MaskedComparison_Arith_rand_words();
+#elif defined(SIMPLE)
+    return MaskedComparison_Simple_rand_words();
+#elif defined(SIMPLENBS)
+    return MaskedComparison_Simple_NBS_rand_words();
+#elif defined(SIMPLENBSO)
+    return MaskedComparison_Simple_NBSO_rand_words();
+#elif defined(GF)
+    return MaskedComparison_GF_rand_words();
+#endif
+}
+
+// offline phase: fill the tape with exactly the randomness of one comparison
+static void tape_prepare(void)
+{
+    size_t len = comparison_rand_words();
+
+    if (len > RNG_TAPE_WORDS)
+    {
+        hal_send_str("[FAIL] RNG_TAPE_WORDS too small for this configuration");
+    }
+    assert(len <= RNG_TAPE_WORDS);
+
+    rng_tape_fill(tape, len);
+    rng_tape_attach(tape, len);
+}
+
+// online phase must have consumed the tape exactly
+static void tape_check(void)
+{
+    if (rng_ctx.tape.pos != rng_ctx.tape.len)
+    {
+        hal_send_str("[FAIL] randomness tape not consumed exactly");
+    }
+    assert(rng_ctx.tape.pos == rng_ctx.tape.len);
+}
+
+#endif
+
 static void get_rand(size_t ncoeffs, uint32_t mod, uint32_t x[ncoeffs])
 {
     for (size_t j = 0; j < ncoeffs; j++)
     {
-        x[j] = random_uint32() % mod;
+        x[j] = test_random_uint32() % mod;
     }
 }
 
@@ -49,7 +118,7 @@ static void mask(size_t nshares, size_t ncoeffs, uint32_t x_masked[ncoeffs][nsha
 
         for (size_t j = 1; j < nshares; j++)
         {
-            uint32_t R = random_uint32() % Q;
+            uint32_t R = test_random_uint32() % Q;
             x_masked[i][0] = (x_masked[i][0] + (Q - R)) % Q;
             x_masked[i][j] = R;
         }
@@ -111,7 +180,10 @@ static int test_MaskedComparison(void)
         compress(NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, public_B);
         compress(NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, public_C);
 
-        
+        #ifdef RNG_TAPE
+        tape_prepare();
+        #endif
+
         #ifdef ARITH
         hal_send_str("===== Start (unmodified ct) ARITH ====");
         PROFILE_TOP_START();
@@ -143,6 +215,9 @@ static int test_MaskedComparison(void)
         result = MaskedComparison_HybridSimple(B, C, public_B, public_C);
         #endif
         PROFILE_TOP_STOP();
+        #ifdef RNG_TAPE
+        tape_check();
+        #endif
         hal_send_str("===== End (unmodified ct) ====");
 
         if (result != 1)
@@ -165,23 +240,27 @@ static int test_MaskedComparison(void)
 
         // introduce error;
         int BorC, coeff, value;
-        BorC = random_uint32() & 1;
+        BorC = test_random_uint32() & 1;
 
         if( BorC == 1)
         {
-            coeff = random_uint32() % NCOEFFS_B;
-            value = random_uint32() % ((1 << COMPRESSTO_B) - 1);
+            coeff = test_random_uint32() % NCOEFFS_B;
+            value = test_random_uint32() % ((1 << COMPRESSTO_B) - 1);
             value++;
             public_B[coeff] = (public_B[coeff] +  value) & ((1 << COMPRESSTO_B) - 1);
         }
         else
         {
-            coeff = random_uint32() % NCOEFFS_C;
-            value = random_uint32() % ((1 << COMPRESSTO_C) - 1);
+            coeff = test_random_uint32() % NCOEFFS_C;
+            value = test_random_uint32() % ((1 << COMPRESSTO_C) - 1);
             value++;
             public_C[coeff] = (public_C[coeff] + value) & ((1 << COMPRESSTO_C) - 1);
         }
-        
+
+        #ifdef RNG_TAPE
+        tape_prepare();
+        #endif
+
         #ifdef ARITH
         hal_send_str("===== Start (modified ct) ARITH ====");
         PROFILE_TOP_START();
@@ -213,6 +292,9 @@ static int test_MaskedComparison(void)
         result = MaskedComparison_HybridSimple(B, C, public_B, public_C);
         #endif
         PROFILE_TOP_STOP();
+        #ifdef RNG_TAPE
+        tape_check();
+        #endif
         hal_send_str("===== End (modified ct) ====");
 
 
@@ -229,9 +311,261 @@ static int test_MaskedComparison(void)
     return 0;
 }
 
+#ifdef BENCH_SECAND
+
+#ifdef RNG_TAPE
+    #error "BENCH_SECAND: the benchmark draws from the RNG, not from a tape"
+#endif
+
+// cycles and random bytes per SecAND32 for the selected variant, averaged over NTESTS dependent calls
+static void bench_SecAND(void)
+{
+    uint32_t x[NSHARES], y[NSHARES], z[NSHARES];
+    uint64_t t0, t1;
+
+    hal_send_str("=====Benchmarking SecAND32 (" SECAND_VARIANT ")====");
+
+    for (size_t j = 0; j < NSHARES; j++)
+    {
+        x[j] = test_random_uint32();
+        y[j] = test_random_uint32();
+    }
+
+    t0 = hal_get_time();
+    for (size_t i = 0; i < NTESTS; i++)
+    {
+        SecAND32(NSHARES, z, x, y);
+        x[i % NSHARES] ^= z[i % NSHARES];
+    }
+    t1 = hal_get_time();
+
+#ifdef DEBUG
+    (void)t0;
+    (void)t1;
+    printf("SecAND32 randombytes: %zu\n", 4 * SecAND32_rand_words(NSHARES));
+#else
+    printcycles("SecAND32 cycles:", (t1 - t0) / NTESTS);
+    printcycles("SecAND32 randombytes:", 4 * SecAND32_rand_words(NSHARES));
+#endif
+}
+
+#endif
+
+#ifdef BENCH_ADDERS
+
+#ifdef RNG_TAPE
+    #error "BENCH_ADDERS: the benchmark draws from the RNG, not from a tape"
+#endif
+
+// SecAND's, cycles and random bytes of one nbits-bit bitsliced addition for every adder topology
+static void bench_SecAdd_bitsliced(size_t nbits)
+{
+    static const char *names[] = {"ripple", "Brent-Kung", "Sklansky", "Kogge-Stone"};
+    lane_t x[nbits][NSHARES], y[nbits][NSHARES], z[nbits][NSHARES];
+    uint32_t words[LANE_WORDS];
+    uint64_t t0, t1;
+
+    for (size_t k = 0; k < nbits; k++)
+    {
+        for (size_t j = 0; j < NSHARES; j++)
+        {
+            for (size_t w = 0; w < LANE_WORDS; w++)
+            {
+                words[w] = test_random_uint32();
+            }
+            lane_from_words(&x[k][j], words);
+
+            for (size_t w = 0; w < LANE_WORDS; w++)
+            {
+                words[w] = test_random_uint32();
+            }
+            lane_from_words(&y[k][j], words);
+        }
+    }
+
+    for (int a = ADDER_RIPPLE; a <= ADDER_KOGGE_STONE; a++)
+    {
+        enum adder_topology adder = (enum adder_topology)a;
+
+        t0 = hal_get_time();
+        for (size_t i = 0; i < NTESTS; i++)
+        {
+            SecAdd_bitsliced_adder(NSHARES, nbits, adder, z, x, y);
+            x[i % nbits][i % NSHARES] ^= z[i % nbits][i % NSHARES];
+        }
+        t1 = hal_get_time();
+
+#ifdef DEBUG
+        (void)t0;
+        (void)t1;
+        printf("%zu bits, %s: SecAND's %zu, randombytes %zu\n", nbits, names[a], SecAdd_bitsliced_adder_nand(nbits, adder), 4 * SecAdd_bitsliced_adder_rand_words(NSHARES, nbits, adder));
+#else
+        hal_send_str(names[a]);
+        printcycles("SecAND's:", SecAdd_bitsliced_adder_nand(nbits, adder));
+        printcycles("cycles:", (t1 - t0) / NTESTS);
+        printcycles("randombytes:", 4 * SecAdd_bitsliced_adder_rand_words(NSHARES, nbits, adder));
+#endif
+    }
+}
+
+#endif
+
+#ifdef BENCH_A2B
+
+#ifdef RNG_TAPE
+    #error "BENCH_A2B: the benchmark draws from the RNG, not from a tape"
+#endif
+
+// cycles and random bytes of one A2B_bitsliced of ncoefs nbits-bit coefficients, averaged over NTESTS dependent calls
+static void bench_A2B_bitsliced(size_t ncoefs, size_t nbits, enum adder_topology adder)
+{
+    uint32_t A[ncoefs][NSHARES], B[ncoefs][NSHARES];
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, nbits)];
+    uint64_t t0, t1;
+
+    for (size_t i = 0; i < ncoefs; i++)
+    {
+        for (size_t j = 0; j < NSHARES; j++)
+        {
+            A[i][j] = test_random_uint32();
+        }
+    }
+
+    t0 = hal_get_time();
+    for (size_t i = 0; i < NTESTS; i++)
+    {
+        A2B_bitsliced(NSHARES, ncoefs, nbits, adder, B, A, workspace);
+        A[i % ncoefs][i % NSHARES] ^= B[i % ncoefs][i % NSHARES];
+    }
+    t1 = hal_get_time();
+
+#ifdef DEBUG
+    (void)t0;
+    (void)t1;
+    printf("%zu x %zu bits: randombytes %zu\n", ncoefs, nbits, 4 * LANE_BATCHES(ncoefs) * A2B_bitsliced_rand_words(NSHARES, nbits, adder));
+#else
+    printcycles("A2B_bitsliced cycles:", (t1 - t0) / NTESTS);
+    printcycles("A2B_bitsliced randombytes:", 4 * LANE_BATCHES(ncoefs) * A2B_bitsliced_rand_words(NSHARES, nbits, adder));
+#endif
+}
+
+// the same for A2B_table, one call per coefficient
+static void bench_A2B_table(size_t ncoefs, size_t nbits)
+{
+    uint32_t A[ncoefs][NSHARES], B[ncoefs][NSHARES];
+    uint64_t t0, t1;
+
+    for (size_t i = 0; i < ncoefs; i++)
+    {
+        for (size_t j = 0; j < NSHARES; j++)
+        {
+            A[i][j] = test_random_uint32();
+        }
+    }
+
+    t0 = hal_get_time();
+    for (size_t i = 0; i < NTESTS; i++)
+    {
+        for (size_t c = 0; c < ncoefs; c++)
+        {
+            A2B_table(NSHARES, nbits, B[c], A[c]);
+        }
+        A[i % ncoefs][i % NSHARES] ^= B[i % ncoefs][i % NSHARES];
+    }
+    t1 = hal_get_time();
+
+#ifdef DEBUG
+    (void)t0;
+    (void)t1;
+    printf("%zu x %zu bits, %d-bit chunks: randombytes %zu\n", ncoefs, nbits, A2B_TABLE_BITS, 4 * ncoefs * A2B_table_rand_words(NSHARES, nbits));
+#else
+    printcycles("A2B_table cycles:", (t1 - t0) / NTESTS);
+    printcycles("A2B_table randombytes:", 4 * ncoefs * A2B_table_rand_words(NSHARES, nbits));
+#endif
+}
+
+#endif
+
+#ifdef BENCH_GF_REDUCE
+
+#ifdef RNG_TAPE
+    #error "BENCH_GF_REDUCE: the benchmark draws from the RNG, not from a tape"
+#endif
+
+// cycles and random bytes of ReduceComparisons_GF and the equality test on its output for every reduction width
+static void bench_GF_reduce(void)
+{
+    static lane_t BC[SIMPLECOMPBITS][NSHARES];
+    uint32_t E[4][NSHARES], words[LANE_WORDS];
+    uint64_t t0, t1, t2, treduce, ttest;
+
+    for (size_t i = 0; i < SIMPLECOMPBITS; i++)
+    {
+        for (size_t j = 0; j < NSHARES; j++)
+        {
+            for (size_t w = 0; w < LANE_WORDS; w++)
+            {
+                words[w] = test_random_uint32();
+            }
+            lane_from_words(&BC[i][j], words);
+        }
+    }
+
+    for (size_t nwords = 1; nwords <= 4; nwords++)
+    {
+        treduce = ttest = 0;
+        for (size_t i = 0; i < NTESTS; i++)
+        {
+            t0 = hal_get_time();
+            ReduceComparisons_GF(nwords, E, BC);
+            t1 = hal_get_time();
+            words[0] ^= BooleanEqualityTest_Simple32(E, nwords);
+            t2 = hal_get_time();
+            lane_from_words(&BC[i % (SIMPLECOMPBITS)][i % NSHARES], words);
+            treduce += t1 - t0;
+            ttest += t2 - t1;
+        }
+
+#ifdef DEBUG
+        (void)treduce;
+        (void)ttest;
+        printf("%zu bits: randombytes %zu + %zu\n", 32 * nwords, 4 * ReduceComparisons_GF_rand_words(nwords),
+               4 * BooleanEqualityTest_Simple32_rand_words(nwords));
+#else
+        printcycles("GF_REDUCE_BITS:", 32 * nwords);
+        printcycles("ReduceComparisons_GF cycles:", treduce / NTESTS);
+        printcycles("ReduceComparisons_GF randombytes:", 4 * ReduceComparisons_GF_rand_words(nwords));
+        printcycles("BooleanEqualityTest_Simple32 cycles:", ttest / NTESTS);
+        printcycles("BooleanEqualityTest_Simple32 randombytes:", 4 * BooleanEqualityTest_Simple32_rand_words(nwords));
+#endif
+    }
+}
+
+#endif
+
 int main(void)
 {
     hal_setup();
+#ifdef BENCH_SECAND
+    bench_SecAND();
+#endif
+#ifdef BENCH_ADDERS
+    hal_send_str("=====Benchmarking SecAdd_bitsliced (B and C widths)====");
+    bench_SecAdd_bitsliced(COMPRESSFROM_B);
+    bench_SecAdd_bitsliced(COMPRESSFROM_C);
+#endif
+#ifdef BENCH_A2B
+    hal_send_str("=====Benchmarking A2B_bitsliced (" TRANSPOSE_VARIANT " transpose, B and C)====");
+    bench_A2B_bitsliced(NCOEFFS_B, COMPRESSFROM_B, ADDER_B);
+    bench_A2B_bitsliced(NCOEFFS_C, COMPRESSFROM_C, ADDER_C);
+    hal_send_str("=====Benchmarking A2B_table (B and C)====");
+    bench_A2B_table(NCOEFFS_B, COMPRESSFROM_B);
+    bench_A2B_table(NCOEFFS_C, COMPRESSFROM_C);
+#endif
+#ifdef BENCH_GF_REDUCE
+    hal_send_str("=====Benchmarking ReduceComparisons_GF (" CLMUL_VARIANT ") and the equality test, 32 to 128 bits====");
+    bench_GF_reduce();
+#endif
     test_MaskedComparison();
     return 0;
 }
\ No newline at end of file
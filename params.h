@@ -74,15 +74,56 @@
     #define COMPRESSTO_B KYBER_DU
     #define COMPRESSTO_C KYBER_DV
 
+    // KYBER_MODQ_A2B: the integer sum of NSHARES shares in [0, Q < 2^12) fits in 12 + ceil(log2(NSHARES)) bits
+    #define MODQ_LOG_NSHARES ((NSHARES > 1) + (NSHARES > 2) + (NSHARES > 4) + (NSHARES > 8) + (NSHARES > 16))
+    #define MODQ_BITS (12 + MODQ_LOG_NSHARES)
+
     #define COMPRESSTO_B_HYBRID 13
     #define COMPRESSFROM_B_HYBRID (COMPRESSTO_B_HYBRID + KYBER_FRAC_BITS)
     #define LB 12 // needs to be even
-    #define SIMPLECOMPBITS_HYBRID COMPRESSTO_B_HYBRID + NCOEFFS_C / 32 * COMPRESSTO_C
+    #define SIMPLECOMPBITS_HYBRID COMPRESSTO_B_HYBRID + LANE_BATCHES(NCOEFFS_C) * COMPRESSTO_C
 #else
 #error
 #endif
 
-#define SIMPLECOMPBITS NCOEFFS_B / 32 * COMPRESSTO_B + NCOEFFS_C / 32 * COMPRESSTO_C
+#ifdef KYBER_MODQ_A2B
+    #ifndef KYBER
+        #error "KYBER_MODQ_A2B needs KYBER"
+    #endif
+    #ifdef PUBLIC_AFTER_A2B
+        #error "KYBER_MODQ_A2B subtracts the public interval before A2B"
+    #endif
+
+    // bitsliced rows of B and C: one out-of-interval bit per batch of LANE_BITS coefficients (Lane.h)
+    #define SIMPLECOMPBITS LANE_BATCHES(NCOEFFS_B) + LANE_BATCHES(NCOEFFS_C)
+#else
+    // bitsliced rows of B and C: COMPRESSTO bits per batch of LANE_BITS coefficients (Lane.h)
+    #define SIMPLECOMPBITS LANE_BATCHES(NCOEFFS_B) * COMPRESSTO_B + LANE_BATCHES(NCOEFFS_C) * COMPRESSTO_C
+#endif
+
+// widest conversion of the bitsliced A2B's, sizes their workspace (A2B.h)
+#define A2B_NBITS ((COMPRESSFROM_B > COMPRESSFROM_C) ? COMPRESSFROM_B : COMPRESSFROM_C)
+#define A2B_NBITS_HYBRID ((COMPRESSFROM_B_HYBRID > COMPRESSFROM_C) ? COMPRESSFROM_B_HYBRID : COMPRESSFROM_C)
+#if defined(GF_STREAMING) && defined(GF_POLYEVAL)
+    #error "GF_STREAMING reduces with ReduceComparisons_GF, GF_POLYEVAL evaluates the rows from the last one down"
+#endif
+
+#ifdef KYBER_MODQ_A2B
+    #define A2B_NBITS_KEEP (MODQ_BITS + 1) // A2B_keepbitsliced_modq in Simple and GF
+#else
+    #define A2B_NBITS_KEEP A2B_NBITS
+#endif
+
+// bitsliced adder topology of the B, C and hybrid B conversions, see enum adder_topology in SecAdd.h
+#ifndef ADDER_B
+    #define ADDER_B ADDER_RIPPLE
+#endif
+#ifndef ADDER_C
+    #define ADDER_C ADDER_RIPPLE
+#endif
+#ifndef ADDER_B_HYBRID
+    #define ADDER_B_HYBRID ADDER_B
+#endif
 
 
 
@@ -26,89 +26,120 @@
 
 #include "A2B.h"
 #include "SecAdd.h"
+#include "SecAnd.h"
+#include "Refresh.h"
+#include "FixedShares.h"
+#include "Transpose.h"
+#include "A2BTable.h"
 #include "randombytes.h"
 
 #ifdef DEBUG
 #include "bitmask.h"
 #endif
 
-// [https://eprint.iacr.org/2018/381.pdf, Algorithm 8]
-static void RefreshXOR(size_t from, size_t to, uint64_t x[to])
-{
-    for (size_t i = from; i < to; i++)
-    {
-        x[i] = 0;
+// fixed-share A2B/A2B32: the recursion on N shares splits into H = N / 2 and L = N - H shares
+#define A2B_FIXED(N, H, L, W, NAME, REFRESH, ADD)                              \
+    static void NAME##_##N(uint##W##_t B[N], const uint##W##_t A[N])           \
+    {                                                                          \
+        uint##W##_t x[N], y[N];                                                \
+                                                                               \
+        NAME##_##H(&x[0], &A[0]);                                              \
+        REFRESH(H, N, x);                                                      \
+        NAME##_##L(&y[0], &A[H]);                                              \
+        REFRESH(L, N, y);                                                      \
+        ADD(N, B, x, y);                                                       \
     }
 
-    for (size_t i = 0; i < to - 1; i++)
-    {
-        for (size_t j = i + 1; j < to; j++)
-        {
-            uint64_t R = random_uint64();
-            x[i] ^= R;
-            x[j] ^= R;
-        }
-    }
+static inline void A2B_1(uint64_t B[1], const uint64_t A[1])
+{
+    B[0] = A[0];
 }
 
-static void RefreshXOR32(size_t from, size_t to, uint32_t x[to])
+static inline void A2B32_1(uint32_t B[1], const uint32_t A[1])
 {
-    for (size_t i = from; i < to; i++)
+    B[0] = A[0];
+}
+
+#define A2B64_FIXED(N, H, L) A2B_FIXED(N, H, L, 64, A2B, RefreshXOR, SecAdd)
+#define A2B32_FIXED(N, H, L) A2B_FIXED(N, H, L, 32, A2B32, RefreshXOR32, SecAdd32)
+
+IF_FIXED_2(A2B64_FIXED(2, 1, 1) A2B32_FIXED(2, 1, 1))
+IF_FIXED_3(A2B64_FIXED(3, 1, 2) A2B32_FIXED(3, 1, 2))
+IF_FIXED_4(A2B64_FIXED(4, 2, 2) A2B32_FIXED(4, 2, 2))
+IF_FIXED_5(A2B64_FIXED(5, 2, 3) A2B32_FIXED(5, 2, 3))
+IF_FIXED_6(A2B64_FIXED(6, 3, 3) A2B32_FIXED(6, 3, 3))
+IF_FIXED_7(A2B64_FIXED(7, 3, 4) A2B32_FIXED(7, 3, 4))
+IF_FIXED_8(A2B64_FIXED(8, 4, 4) A2B32_FIXED(8, 4, 4))
+
+/*
+* The generic conversions run the tree of [secconvorder, Algorithm 4] bottom-up: step s merges the converted shares
+* [off, off + h) and [off + h, off + m) into the m shares at off. The tree is split breadth-first as in the recursion
+* (h = m / 2), and reversed so that both halves are merged before their parent; nshares - 1 steps in all.
+*/
+void A2B_schedule(size_t nshares, struct a2b_step steps[nshares])
+{
+    size_t len = 0;
+
+    if (nshares > 1)
     {
-        x[i] = 0;
+        steps[len++] = (struct a2b_step){0, nshares / 2, nshares};
     }
 
-    for (size_t i = 0; i < to - 1; i++)
+    for (size_t i = 0; i < len; i++)
     {
-        for (size_t j = i + 1; j < to; j++)
+        struct a2b_step s = steps[i];
+
+        if (s.h > 1)
         {
-            uint32_t R = random_uint32();
-            x[i] ^= R;
-            x[j] ^= R;
+            steps[len++] = (struct a2b_step){s.off, s.h / 2, s.h};
         }
-    }
-}
-
-static void RefreshXOR_bitsliced(size_t from, size_t to, size_t nbits, uint32_t x[to][nbits])
-{
-    for (size_t i = from; i < to; i++)
-    {
-        for (size_t k = 0; k < nbits; k++)
+        if (s.m - s.h > 1)
         {
-            x[i][k] = 0;
+            steps[len++] = (struct a2b_step){s.off + s.h, (s.m - s.h) / 2, s.m - s.h};
         }
     }
 
-    for (size_t i = 0; i < to - 1; i++)
+    for (size_t i = 0; i < len / 2; i++)
     {
-        for (size_t j = i + 1; j < to; j++)
-        {
-            for (size_t k = 0; k < nbits; k++)
-            {
-                uint32_t R = random_uint32();
-                x[i][k] ^= R;
-                x[j][k] ^= R;
-            }
-        }
+        struct a2b_step t = steps[i];
+
+        steps[i] = steps[len - 1 - i];
+        steps[len - 1 - i] = t;
     }
 }
 
 // [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 4]
 void A2B(size_t nshares, uint64_t B[nshares], const uint64_t A[nshares])
 {
-    if (nshares == 1)
+    FIXED_DISPATCH(nshares, A2B, (B, A));
+
+    uint64_t x[nshares], y[nshares];
+    struct a2b_step steps[nshares];
+
+    A2B_schedule(nshares, steps);
+
+    for (size_t j = 0; j < nshares; j++)
     {
-        B[0] = A[0];
-        return;
+        B[j] = A[j];
     }
 
-    uint64_t x[nshares], y[nshares];
+    for (size_t s = 0; s + 1 < nshares; s++)
+    {
+        size_t off = steps[s].off, h = steps[s].h, m = steps[s].m;
 
-    A2B(nshares / 2, &x[0], &A[0]);
-    RefreshXOR(nshares / 2, nshares, x);
-    A2B(nshares - (nshares / 2), &y[0], &A[nshares / 2]);
-    RefreshXOR(nshares - (nshares / 2), nshares, y);
-    SecAdd(nshares, B, x, y);
+        for (size_t j = 0; j < h; j++)
+        {
+            x[j] = B[off + j];
+        }
+        for (size_t j = 0; j < m - h; j++)
+        {
+            y[j] = B[off + h + j];
+        }
+
+        RefreshXOR(h, m, x);
+        RefreshXOR(m - h, m, y);
+        SecAdd(m, &B[off], x, y);
+    }
 
 #ifdef DEBUG
     uint64_t A_unmasked = 0;
@@ -127,19 +158,35 @@ void A2B(size_t nshares, uint64_t B[nshares], const uint64_t A[nshares])
 // [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 4]
 void A2B32(size_t nshares, uint32_t B[nshares], const uint32_t A[nshares])
 {
-    if (nshares == 1)
+    FIXED_DISPATCH(nshares, A2B32, (B, A));
+
+    uint32_t x[nshares], y[nshares];
+    struct a2b_step steps[nshares];
+
+    A2B_schedule(nshares, steps);
+
+    for (size_t j = 0; j < nshares; j++)
     {
-        B[0] = A[0];
-        return;
+        B[j] = A[j];
     }
 
-    uint32_t x[nshares], y[nshares];
+    for (size_t s = 0; s + 1 < nshares; s++)
+    {
+        size_t off = steps[s].off, h = steps[s].h, m = steps[s].m;
 
-    A2B32(nshares / 2, &x[0], &A[0]);
-    RefreshXOR32(nshares / 2, nshares, x);
-    A2B32(nshares - (nshares / 2), &y[0], &A[nshares / 2]);
-    RefreshXOR32(nshares - (nshares / 2), nshares, y);
-    SecAdd32(nshares, B, x, y);
+        for (size_t j = 0; j < h; j++)
+        {
+            x[j] = B[off + j];
+        }
+        for (size_t j = 0; j < m - h; j++)
+        {
+            y[j] = B[off + h + j];
+        }
+
+        RefreshXOR32(h, m, x);
+        RefreshXOR32(m - h, m, y);
+        SecAdd32(m, &B[off], x, y);
+    }
 
 #ifdef DEBUG
     uint32_t A_unmasked = 0;
@@ -155,77 +202,151 @@ void A2B32(size_t nshares, uint32_t B[nshares], const uint32_t A[nshares])
 #endif
 }
 
-static void A2B_bitsliced_inner(size_t nshares, size_t nbits, uint32_t B_bitsliced[nshares][nbits], const uint32_t A_bitsliced[nshares][nbits])
+// workspace: the two widened halves and the sum of one merge, nbits x nshares lanes each
+static void A2B_bitsliced_inner(size_t nshares, size_t nbits, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t B_bitsliced[nbits][nshares], const lane_t A_bitsliced[nbits][nshares], lane_t workspace[])
 {
-    if (nshares == 1)
+    for (size_t k = 0; k < nbits; k++)
     {
-        for (size_t i = 0; i < nbits; i++)
+        for (size_t j = 0; j < nshares; j++)
         {
-            B_bitsliced[0][i] = A_bitsliced[0][i];
+            B_bitsliced[k][j] = A_bitsliced[k][j];
         }
-        return;
     }
 
-    uint32_t x[nshares][nbits], y[nshares][nbits];
+    for (size_t s = 0; s + 1 < nshares; s++)
+    {
+        size_t off = steps[s].off, h = steps[s].h, m = steps[s].m;
+        lane_t (*x)[m] = (lane_t (*)[m])&workspace[0];
+        lane_t (*y)[m] = (lane_t (*)[m])&workspace[nbits * nshares];
+        // the last merge covers all shares and writes B directly
+        lane_t (*z)[m] = (m == nshares) ? B_bitsliced : (lane_t (*)[m])&workspace[2 * nbits * nshares];
+
+        // widen both halves to m shares, the refresh below zeroes the upper shares
+        for (size_t k = 0; k < nbits; k++)
+        {
+            for (size_t j = 0; j < h; j++)
+            {
+                x[k][j] = B_bitsliced[k][off + j];
+            }
+            for (size_t j = 0; j < m - h; j++)
+            {
+                y[k][j] = B_bitsliced[k][off + h + j];
+            }
+        }
+
+        RefreshXOR_bitsliced(h, m, nbits, x);
+        RefreshXOR_bitsliced(m - h, m, nbits, y);
+        SecAdd_bitsliced_adder(m, nbits, adder, z, x, y);
 
-    A2B_bitsliced_inner(nshares / 2, nbits, &x[0], &A_bitsliced[0]);
-    RefreshXOR_bitsliced(nshares / 2, nshares, nbits, x);
-    A2B_bitsliced_inner(nshares - (nshares / 2), nbits, &y[0], &A_bitsliced[nshares / 2]);
-    RefreshXOR_bitsliced(nshares - (nshares / 2), nshares, nbits, y);
-    SecAdd_bitsliced(nshares, nbits, B_bitsliced, x, y);
+        if (m != nshares)
+        {
+            for (size_t k = 0; k < nbits; k++)
+            {
+                for (size_t j = 0; j < m; j++)
+                {
+                    B_bitsliced[k][off + j] = z[k][j];
+                }
+            }
+        }
+    }
 }
 
-static void pack_bitslice(size_t nshares, size_t nbits, uint32_t x_bitsliced[nshares][nbits], const uint32_t x[32][nshares])
+// 32-bit lanes are transposed 32 coefficients at a time, wider lanes 64 at a time (Transpose.c)
+#if LANE_BITS == 32
+    #define BLOCK_BITS 32
+    typedef uint32_t block_t;
+    #define bitslice_block bitslice32
+    #define unbitslice_block unbitslice32
+#else
+    #define BLOCK_BITS 64
+    typedef uint64_t block_t;
+    #define bitslice_block bitslice64
+    #define unbitslice_block unbitslice64
+#endif
+
+static void pack_bitslice(size_t nshares, size_t nbits, size_t count, lane_t x_bitsliced[nbits][nshares], const uint32_t x[count][nshares])
 {
+    // one share of the count coefficients, zero-padded to LANE_BITS, is transposed per block, then stored as [nbits][nshares]
+    uint32_t col[LANE_BITS];
+    block_t planes[LANE_BITS / BLOCK_BITS][nbits];
+    uint32_t words[LANE_WORDS];
+
     for (size_t j = 0; j < nshares; j++)
     {
-        for (size_t k = 0; k < nbits; k++)
+        for (size_t i = 0; i < LANE_BITS; i++)
         {
-            x_bitsliced[j][k] = 0;
+            col[i] = (i < count) ? x[i][j] : 0;
         }
-    }
 
-    for (size_t i = 0; i < 32; i++)
-    {
-        for (size_t j = 0; j < nshares; j++)
+        for (size_t e = 0; e < LANE_BITS / BLOCK_BITS; e++)
         {
-            for (size_t k = 0; k < nbits; k++)
+            bitslice_block(nbits, planes[e], &col[BLOCK_BITS * e]);
+        }
+
+        for (size_t k = 0; k < nbits; k++)
+        {
+            for (size_t w = 0; w < LANE_WORDS; w++)
             {
-                x_bitsliced[j][k] = x_bitsliced[j][k] | (((x[i][j] >> k) & 1) << i);
+                words[w] = (uint32_t)(planes[32 * w / BLOCK_BITS][k] >> (32 * w % BLOCK_BITS));
             }
+
+            lane_from_words(&x_bitsliced[k][j], words);
         }
     }
 }
 
-static void unpack_bitslice(size_t nshares, size_t nbits, uint32_t x[32][nshares], uint32_t x_bitsliced[nshares][nbits])
+static void unpack_bitslice(size_t nshares, size_t nbits, size_t count, uint32_t x[count][nshares], lane_t x_bitsliced[nbits][nshares])
 {
-    for (size_t i = 0; i < 32; i++)
+    uint32_t col[LANE_BITS];
+    block_t planes[LANE_BITS / BLOCK_BITS][nbits];
+
+    for (size_t j = 0; j < nshares; j++)
     {
-        for (size_t j = 0; j < nshares; j++)
+        for (size_t k = 0; k < nbits; k++)
         {
-            uint32_t tmp = 0;
+            for (size_t e = 0; e < LANE_BITS / BLOCK_BITS; e++)
+            {
+                planes[e][k] = 0;
+            }
 
-            for (size_t k = 0; k < nbits; k++)
+            for (size_t w = 0; w < LANE_WORDS; w++)
             {
-                tmp |= ((x_bitsliced[j][k] & (1 << i)) >> i) << k;
+                planes[32 * w / BLOCK_BITS][k] |= ((block_t)lane_word(&x_bitsliced[k][j], w)) << (32 * w % BLOCK_BITS);
             }
+        }
 
-            x[i][j] = tmp;
+        for (size_t e = 0; e < LANE_BITS / BLOCK_BITS; e++)
+        {
+            unbitslice_block(nbits, &col[BLOCK_BITS * e], planes[e]);
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            x[i][j] = col[i];
         }
     }
 }
 
-void A2B_bitsliced(size_t nshares, size_t nbits, uint32_t B[32][nshares], const uint32_t A[32][nshares])
+// ncoefs coefficients, converted in batches of LANE_BITS
+void A2B_bitsliced(size_t nshares, size_t ncoefs, size_t nbits, enum adder_topology adder, uint32_t B[ncoefs][nshares], const uint32_t A[ncoefs][nshares], lane_t workspace[])
 {
-    uint32_t A_bitsliced[nshares][nbits];
-    uint32_t B_bitsliced[nshares][nbits];
+    lane_t (*A_bitsliced)[nshares] = (lane_t (*)[nshares])&workspace[0];
+    lane_t (*B_bitsliced)[nshares] = (lane_t (*)[nshares])&workspace[nbits * nshares];
+    struct a2b_step steps[nshares];
 
-    pack_bitslice(nshares, nbits, A_bitsliced, A);
-    A2B_bitsliced_inner(nshares, nbits, B_bitsliced, A_bitsliced);
-    unpack_bitslice(nshares, nbits, B, B_bitsliced);
+    A2B_schedule(nshares, steps);
+
+    for (size_t i = 0; i < ncoefs; i += LANE_BITS)
+    {
+        size_t count = (ncoefs - i < LANE_BITS) ? ncoefs - i : LANE_BITS;
+
+        pack_bitslice(nshares, nbits, count, A_bitsliced, &A[i]);
+        A2B_bitsliced_inner(nshares, nbits, adder, steps, B_bitsliced, A_bitsliced, &workspace[2 * nbits * nshares]);
+        unpack_bitslice(nshares, nbits, count, &B[i], B_bitsliced);
+    }
 
 #ifdef DEBUG
-    for (size_t i = 0; i < 32; i++)
+    for (size_t i = 0; i < ncoefs; i++)
     {
         uint32_t A_unmasked = 0;
         uint32_t B_unmasked = 0;
@@ -241,42 +362,271 @@ void A2B_bitsliced(size_t nshares, size_t nbits, uint32_t B[32][nshares], const
 #endif
 }
 
-void A2B_keepbitsliced(size_t nshares, uint32_t ncoefsb, uint32_t compressfrom_b, uint32_t compressto_b, uint32_t ncoefsc, uint32_t compressfrom_c, uint32_t compressto_c, uint32_t out[SIMPLECOMPBITS][NSHARES], const uint32_t Bp[ncoefsb][NSHARES], const uint32_t Cp[ncoefsc][NSHARES])
+// one batch of count coefficients to nbits bit planes, A_bitsliced and workspace are scratch
+static void A2B_keepbitsliced_batch(size_t nshares, size_t nbits, size_t count, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t B_bitsliced[nbits][nshares], lane_t A_bitsliced[nbits][nshares], const uint32_t A[count][nshares], lane_t workspace[])
+{
+#ifdef A2B_TABLE
+    // converted per coefficient (A2BTable.c), then packed: packing is share-wise, so the shares stay Boolean
+    uint32_t B[count][nshares];
+
+    (void)adder;
+    (void)steps;
+    (void)A_bitsliced;
+    (void)workspace;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        A2B_table(nshares, nbits, B[i], A[i]);
+    }
+
+    pack_bitslice(nshares, nbits, count, B_bitsliced, (const uint32_t (*)[nshares])B);
+#else
+    // pack to bitslice, then A2B
+    // don't unpack
+    pack_bitslice(nshares, nbits, count, A_bitsliced, A);
+    A2B_bitsliced_inner(nshares, nbits, adder, steps, B_bitsliced, A_bitsliced, workspace);
+#endif
+}
+
+void A2B_keepbitsliced(size_t nshares, uint32_t ncoefsb, uint32_t compressfrom_b, uint32_t compressto_b, enum adder_topology adder_b, uint32_t ncoefsc, uint32_t compressfrom_c, uint32_t compressto_c, enum adder_topology adder_c, lane_t out[SIMPLECOMPBITS][NSHARES], const uint32_t Bp[ncoefsb][NSHARES], const uint32_t Cp[ncoefsc][NSHARES], lane_t workspace[])
 {
-    uint32_t B1_bitsliced[nshares][compressfrom_b];
-    uint32_t B2_bitsliced[nshares][compressfrom_b];
-    uint32_t C1_bitsliced[nshares][compressfrom_c];
-    uint32_t C2_bitsliced[nshares][compressfrom_c];
+    struct a2b_step steps[nshares];
+
+    A2B_schedule(nshares, steps);
 
     // convert B
-    for (size_t i = 0; i < ncoefsb; i += 32)
+    for (size_t i = 0; i < ncoefsb; i += LANE_BITS)
     {
-        // pack to bitslice, then A2B
-        // don't unpack
-        pack_bitslice(nshares, compressfrom_b, B1_bitsliced, &Bp[i]);
-        A2B_bitsliced_inner(nshares, compressfrom_b, B2_bitsliced, B1_bitsliced);
+        size_t count = (ncoefsb - i < LANE_BITS) ? ncoefsb - i : LANE_BITS;
+
+        A2B_keepbitsliced_one_batch(nshares, count, compressfrom_b, compressto_b, adder_b, steps, &out[i / LANE_BITS * compressto_b], &Bp[i], workspace);
+    }
+
+    // convert C
+    for (size_t i = 0; i < ncoefsc; i += LANE_BITS)
+    {
+        size_t count = (ncoefsc - i < LANE_BITS) ? ncoefsc - i : LANE_BITS;
+
+        A2B_keepbitsliced_one_batch(nshares, count, compressfrom_c, compressto_c, adder_c, steps, &out[LANE_BATCHES(ncoefsb) * compressto_b + i / LANE_BITS * compressto_c], &Cp[i], workspace);
+    }
+}
+
+void A2B_keepbitsliced_one_batch(size_t nshares, size_t count, uint32_t compressfrom, uint32_t compressto, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t out[compressto][NSHARES], const uint32_t A[count][NSHARES], lane_t workspace[])
+{
+    lane_t (*A_bitsliced)[nshares] = (lane_t (*)[nshares])&workspace[0];
+    lane_t (*B_bitsliced)[nshares] = (lane_t (*)[nshares])&workspace[compressfrom * nshares];
+
+    A2B_keepbitsliced_batch(nshares, compressfrom, count, adder, steps, B_bitsliced, A_bitsliced, A, &workspace[2 * compressfrom * nshares]);
+    for (size_t k = 0; k < compressto; k++)
+    {
+        for (size_t j = 0; j < nshares; j++)
+        {
+            out[k][j] = B_bitsliced[k + compressfrom - compressto][j];
+        }
+    }
+}
+
+#ifdef KYBER_MODQ_A2B
+/*
+* One batch of count coefficients with shares in [0, Q) to a single bit plane, set where y = sum(A) mod Q is not below
+* width. The exact sum S < nshares * Q is converted on MODQ_BITS planes, then reduced by conditional subtractions of
+* Q * 2^s for s = MODQ_LOG_NSHARES - 1 down to 0: u = S + 2^(14 + s) - Q * 2^s has bit 13 + s clear iff S >= Q * 2^s,
+* and selects S ^= ge & (u ^ S). Finally y >= width iff bit 12 of y + 2^12 - width is set (y < Q < 2^12, width <= 2^12).
+* Padding lanes have y = 0 and constant 0, so they never flag.
+*/
+static void A2B_modq_batch(size_t nshares, size_t count, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t out[nshares], const uint32_t A[count][nshares], const uint32_t width[count], lane_t workspace[])
+{
+    const size_t nbits = MODQ_BITS;
+    lane_t (*A_bitsliced)[nshares] = (lane_t (*)[nshares])&workspace[0];
+    lane_t (*S)[nshares] = (lane_t (*)[nshares])&workspace[nbits * nshares];
+    lane_t (*U)[nshares] = (lane_t (*)[nshares])&workspace[(2 * nbits + 1) * nshares];
+    lane_t (*GE)[nshares] = (lane_t (*)[nshares])&workspace[(3 * nbits + 2) * nshares];
+    lane_t (*D)[nshares] = A_bitsliced;
+    lane_t ones = ~(lane_t){0};
+    lane_t c[nbits + 1];
+    uint32_t range[count][1];
+
+    // S in planes 0..nbits-1, the A2B scratch (U onwards) is free afterwards
+    A2B_keepbitsliced_batch(nshares, nbits, count, adder, steps, S, A_bitsliced, A, &workspace[(2 * nbits + 1) * nshares]);
+
+    for (size_t j = 0; j < nshares; j++)
+    {
+        S[nbits][j] = (lane_t){0};
+    }
+
+    // before subtracting Q * 2^s, S < Q * 2^(s + 1) < 2^(13 + s): the planes above are masked zeros and are skipped
+    for (size_t s = MODQ_LOG_NSHARES; s-- > 0;)
+    {
+        size_t nb = 13 + s;
+        uint32_t sub = ((uint32_t)1 << (nb + 1)) - ((uint32_t)Q << s);
+
+        for (size_t k = 0; k <= nb; k++)
+        {
+            c[k] = ((sub >> k) & 1) ? ones : (lane_t){0};
+        }
+
+        SecConstAdd_bitsliced(nshares, nb + 1, U, S, c);
+
+        // ge and u ^ S both depend on S: refresh ge before it is multiplied with every plane
         for (size_t j = 0; j < nshares; j++)
         {
-            for (size_t k = 0; k < compressto_b; k++)
+            GE[0][j] = U[nb][j];
+        }
+        GE[0][0] ^= ones;
+        RefreshXORL(nshares, nshares, GE[0]);
+
+        for (size_t k = 0; k < nb; k++)
+        {
+            for (size_t j = 0; j < nshares; j++)
+            {
+                GE[k][j] = GE[0][j];
+                D[k][j] = U[k][j] ^ S[k][j];
+            }
+        }
+
+        SecANDL_batch(nshares, nb, U, GE, D);
+
+        for (size_t k = 0; k < nb; k++)
+        {
+            for (size_t j = 0; j < nshares; j++)
             {
-                out[i / 32 * compressto_b + k][j] = B2_bitsliced[j][k + compressfrom_b - compressto_b];
+                S[k][j] ^= U[k][j];
             }
         }
     }
 
-    // convert C
-    for (size_t i = 0; i < ncoefsc; i += 32)
+#ifdef DEBUG
+    for (size_t i = 0; i < count; i++)
     {
-        // pack to bitslice, then A2B
-        // don't unpack
-        pack_bitslice(nshares, compressfrom_c, C1_bitsliced, &Cp[i]);
-        A2B_bitsliced_inner(nshares, compressfrom_c, C2_bitsliced, C1_bitsliced);
+        uint32_t A_unmasked = 0, S_unmasked = 0;
+
         for (size_t j = 0; j < nshares; j++)
         {
-            for (size_t k = 0; k < compressto_c; k++)
+            A_unmasked += A[i][j];
+            for (size_t k = 0; k < nbits; k++)
             {
-                out[ncoefsb / 32 * compressto_b + i / 32 * compressto_c + k][j] = C2_bitsliced[j][k + compressfrom_c - compressto_c];
+                S_unmasked ^= lane_bit(&S[k][j], i) << k;
             }
         }
+
+        assert(A_unmasked % Q == S_unmasked);
+    }
+#endif
+
+    // y >= width: bit 12 of y + 2^12 - width, on 13 planes
+    for (size_t i = 0; i < count; i++)
+    {
+        range[i][0] = (1 << 12) - width[i];
+    }
+
+    pack_bitslice(1, 13, count, (lane_t (*)[1])c, (const uint32_t (*)[1])range);
+    SecConstAdd_bitsliced(nshares, 13, U, S, c);
+
+    for (size_t j = 0; j < nshares; j++)
+    {
+        out[j] = U[12][j];
     }
 }
+
+/*
+* KYBER_MODQ_A2B: B and C with shares in [0, Q), already shifted by the lower end of their public interval, to one bit
+* plane per batch of LANE_BITS coefficients (B first), set for the coefficients outside [0, width). All are zero iff
+* every coefficient compresses to its public value, without scaling the shares to fractional bits.
+*/
+void A2B_keepbitsliced_modq(size_t nshares, uint32_t ncoefsb, uint32_t ncoefsc, enum adder_topology adder, lane_t out[SIMPLECOMPBITS][NSHARES], const uint32_t Bp[ncoefsb][NSHARES], const uint32_t Cp[ncoefsc][NSHARES], const uint32_t width_b[ncoefsb], const uint32_t width_c[ncoefsc], lane_t workspace[])
+{
+    struct a2b_step steps[nshares];
+
+    A2B_schedule(nshares, steps);
+
+    for (size_t i = 0; i < ncoefsb; i += LANE_BITS)
+    {
+        size_t count = (ncoefsb - i < LANE_BITS) ? ncoefsb - i : LANE_BITS;
+
+        A2B_modq_batch(nshares, count, adder, steps, out[i / LANE_BITS], &Bp[i], &width_b[i], workspace);
+    }
+
+    for (size_t i = 0; i < ncoefsc; i += LANE_BITS)
+    {
+        size_t count = (ncoefsc - i < LANE_BITS) ? ncoefsc - i : LANE_BITS;
+
+        A2B_modq_batch(nshares, count, adder, steps, out[LANE_BATCHES(ncoefsb) + i / LANE_BITS], &Cp[i], &width_c[i], workspace);
+    }
+}
+
+void A2B_keepbitsliced_modq_one_batch(size_t nshares, size_t count, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t out[NSHARES], const uint32_t A[count][NSHARES], const uint32_t width[count], lane_t workspace[])
+{
+    A2B_modq_batch(nshares, count, adder, steps, out, A, width, workspace);
+}
+#endif
+
+// number of 32-bit random words drawn per call
+size_t A2B_rand_words(size_t nshares)
+{
+    if (nshares == 1)
+    {
+        return 0;
+    }
+
+    size_t refresh = RefreshXOR_rand_words(nshares);
+
+    return A2B_rand_words(nshares / 2) + A2B_rand_words(nshares - (nshares / 2)) + 2 * refresh + SecAdd_rand_words(nshares);
+}
+
+size_t A2B32_rand_words(size_t nshares)
+{
+    if (nshares == 1)
+    {
+        return 0;
+    }
+
+    size_t refresh = RefreshXOR32_rand_words(nshares);
+
+    return A2B32_rand_words(nshares / 2) + A2B32_rand_words(nshares - (nshares / 2)) + 2 * refresh + SecAdd32_rand_words(nshares);
+}
+
+// per batch of LANE_BITS coefficients
+size_t A2B_bitsliced_rand_words(size_t nshares, size_t nbits, enum adder_topology adder)
+{
+    if (nshares == 1)
+    {
+        return 0;
+    }
+
+    size_t refresh = RefreshXOR_bitsliced_rand_words(nshares, nbits);
+
+    return A2B_bitsliced_rand_words(nshares / 2, nbits, adder) + A2B_bitsliced_rand_words(nshares - (nshares / 2), nbits, adder) + 2 * refresh + SecAdd_bitsliced_adder_rand_words(nshares, nbits, adder);
+}
+
+// in lanes: the packed input and output of one batch, and the merges of A2B_bitsliced_inner
+size_t A2B_bitsliced_workspace_size(size_t nshares, size_t nbits)
+{
+    return 5 * nbits * nshares;
+}
+
+size_t A2B_keepbitsliced_rand_words(size_t nshares, uint32_t ncoefsb, uint32_t compressfrom_b, enum adder_topology adder_b, uint32_t ncoefsc, uint32_t compressfrom_c, enum adder_topology adder_c)
+{
+#ifdef A2B_TABLE
+    (void)adder_b;
+    (void)adder_c;
+
+    return ncoefsb * A2B_table_rand_words(nshares, compressfrom_b) + ncoefsc * A2B_table_rand_words(nshares, compressfrom_c);
+#else
+    return LANE_BATCHES(ncoefsb) * A2B_bitsliced_rand_words(nshares, compressfrom_b, adder_b) + LANE_BATCHES(ncoefsc) * A2B_bitsliced_rand_words(nshares, compressfrom_c, adder_c);
+#endif
+}
+
+#ifdef KYBER_MODQ_A2B
+// the conversions on MODQ_BITS planes, then per batch the conditional subtractions and the range check
+size_t A2B_keepbitsliced_modq_rand_words(size_t nshares, uint32_t ncoefsb, uint32_t ncoefsc, enum adder_topology adder)
+{
+    size_t batch = SecConstAdd_bitsliced_rand_words(nshares, 13);
+
+    for (size_t s = 0; s < MODQ_LOG_NSHARES; s++)
+    {
+        batch += SecConstAdd_bitsliced_rand_words(nshares, 14 + s) + RefreshXORL_rand_words(nshares) + (13 + s) * SecANDL_rand_words(nshares);
+    }
+
+    return A2B_keepbitsliced_rand_words(nshares, ncoefsb, MODQ_BITS, adder, ncoefsc, MODQ_BITS, adder) + (LANE_BATCHES(ncoefsb) + LANE_BATCHES(ncoefsc)) * batch;
+}
+#endif
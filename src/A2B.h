@@ -30,15 +30,52 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "params.h"
+#include "SecAdd.h"
 
 #ifdef DEBUG
 #include <stdio.h>
 #include <assert.h>
 #endif
 
+// one merge of the share tree of the generic conversions, see A2B.c
+struct a2b_step
+{
+    size_t off, h, m;
+};
+
+// the nshares - 1 merges in order, built once per conversion and shared by all its batches
+void A2B_schedule(size_t nshares, struct a2b_step steps[nshares]);
+
 void A2B(size_t nshares, uint64_t B[nshares], const uint64_t A[nshares]);
 void A2B32(size_t nshares, uint32_t B[nshares], const uint32_t A[nshares]);
-void A2B_bitsliced(size_t nshares, size_t nbits, uint32_t B[32][nshares], const uint32_t A[32][nshares]);
-void A2B_keepbitsliced(size_t nshares, uint32_t ncoefsb, uint32_t compressfrom_b, uint32_t compressto_b, uint32_t ncoefsc, uint32_t compressfrom_c, uint32_t compressto_c, uint32_t out[SIMPLECOMPBITS][NSHARES], const uint32_t Bp[ncoefsb][NSHARES], const uint32_t Cp[ncoefsc][NSHARES]);
+void A2B_bitsliced(size_t nshares, size_t ncoefs, size_t nbits, enum adder_topology adder, uint32_t B[ncoefs][nshares], const uint32_t A[ncoefs][nshares], lane_t workspace[]);
+void A2B_keepbitsliced(size_t nshares, uint32_t ncoefsb, uint32_t compressfrom_b, uint32_t compressto_b, enum adder_topology adder_b, uint32_t ncoefsc, uint32_t compressfrom_c, uint32_t compressto_c, enum adder_topology adder_c, lane_t out[SIMPLECOMPBITS][NSHARES], const uint32_t Bp[ncoefsb][NSHARES], const uint32_t Cp[ncoefsc][NSHARES], lane_t workspace[]);
+
+// one batch of count <= LANE_BITS coefficients of A2B_keepbitsliced to its compressto kept bit planes, for GF_STREAMING
+// steps is the A2B_schedule of nshares, built once by the caller
+void A2B_keepbitsliced_one_batch(size_t nshares, size_t count, uint32_t compressfrom, uint32_t compressto, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t out[compressto][NSHARES], const uint32_t A[count][NSHARES], lane_t workspace[]);
+
+/*
+* A2B_bitsliced and A2B_keepbitsliced keep all their intermediate bit planes in a caller-provided workspace of
+* A2B_bitsliced_workspace_size(nshares, nbits) lanes, with nbits the widest conversion (compressfrom_b and compressfrom_c
+* for A2B_keepbitsliced). It is allocated once and reused for every batch and conversion.
+*/
+size_t A2B_bitsliced_workspace_size(size_t nshares, size_t nbits);
+
+#ifdef KYBER_MODQ_A2B
+/*
+* Kyber: converts shares in [0, Q) on MODQ_BITS planes and reduces mod Q in the masked domain, instead of scaling them to
+* COMPRESSFROM fractional bits. One bit plane per batch, set where the coefficient is outside [0, width), see A2B.c.
+* The workspace is A2B_bitsliced_workspace_size(nshares, MODQ_BITS + 1) lanes.
+*/
+void A2B_keepbitsliced_modq(size_t nshares, uint32_t ncoefsb, uint32_t ncoefsc, enum adder_topology adder, lane_t out[SIMPLECOMPBITS][NSHARES], const uint32_t Bp[ncoefsb][NSHARES], const uint32_t Cp[ncoefsc][NSHARES], const uint32_t width_b[ncoefsb], const uint32_t width_c[ncoefsc], lane_t workspace[]);
+void A2B_keepbitsliced_modq_one_batch(size_t nshares, size_t count, enum adder_topology adder, const struct a2b_step steps[nshares], lane_t out[NSHARES], const uint32_t A[count][NSHARES], const uint32_t width[count], lane_t workspace[]);
+size_t A2B_keepbitsliced_modq_rand_words(size_t nshares, uint32_t ncoefsb, uint32_t ncoefsc, enum adder_topology adder);
+#endif
+
+size_t A2B_rand_words(size_t nshares);
+size_t A2B32_rand_words(size_t nshares);
+size_t A2B_bitsliced_rand_words(size_t nshares, size_t nbits, enum adder_topology adder);
+size_t A2B_keepbitsliced_rand_words(size_t nshares, uint32_t ncoefsb, uint32_t compressfrom_b, enum adder_topology adder_b, uint32_t ncoefsc, uint32_t compressfrom_c, enum adder_topology adder_c);
 
 #endif // A2B_H
\ No newline at end of file
@@ -0,0 +1,165 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "A2BTable.h"
+#include "Refresh.h"
+#include "randombytes.h"
+
+#define LUT_BITS (A2B_TABLE_BITS + 1)
+#define LUT_ROWS (1 << LUT_BITS)
+#define LUT_MASK ((1u << LUT_BITS) - 1)
+#define LUT_MASKS_PER_WORD (32 / LUT_BITS) // RefreshMasks draws LUT_BITS-bit masks, packed in 32-bit words
+
+// words for the masks of one shift round: nshares - 1 per row
+#define LUT_ROUND_WORDS(nshares) ((LUT_ROWS * ((nshares) - 1) + LUT_MASKS_PER_WORD - 1) / LUT_MASKS_PER_WORD)
+
+/*
+* y = S(x) on Boolean shares of LUT_BITS bits [Coron, EUROCRYPT 2014, Algorithm 3]: the table starts as (S(u), 0, .., 0),
+* is shifted by x_0 .. x_(nshares-2) with every row refreshed (RefreshMasks) after each shift, and row x_(nshares-1)
+* is read and refreshed with RefreshXOR32.
+*/
+static void SecLUT(size_t nshares, uint32_t y[nshares], const uint32_t x[nshares], const uint32_t S[LUT_ROWS])
+{
+    uint32_t T[2][LUT_ROWS][nshares];
+    uint32_t r[LUT_ROUND_WORDS(nshares)];
+    size_t cur = 0;
+
+    for (size_t u = 0; u < LUT_ROWS; u++)
+    {
+        T[cur][u][0] = S[u];
+
+        for (size_t j = 1; j < nshares; j++)
+        {
+            T[cur][u][j] = 0;
+        }
+    }
+
+    for (size_t i = 0; i + 1 < nshares; i++)
+    {
+        size_t m = 0;
+
+        PROFILE_RAND_GADGET(RNG_GADGET_SECLUT);
+        random_uint32_n(r, LUT_ROUND_WORDS(nshares));
+
+        for (size_t u = 0; u < LUT_ROWS; u++)
+        {
+            const uint32_t *row = T[cur][u ^ x[i]];
+
+            T[1 - cur][u][0] = row[0];
+
+            for (size_t j = 1; j < nshares; j++, m++)
+            {
+                uint32_t mask = (r[m / LUT_MASKS_PER_WORD] >> (LUT_BITS * (m % LUT_MASKS_PER_WORD))) & LUT_MASK;
+
+                T[1 - cur][u][0] ^= mask;
+                T[1 - cur][u][j] = row[j] ^ mask;
+            }
+        }
+
+        cur = 1 - cur;
+
+        PROFILE_RAND_GADGET_END();
+    }
+
+    for (size_t j = 0; j < nshares; j++)
+    {
+        y[j] = T[cur][x[nshares - 1]][j];
+    }
+
+    RefreshXOR32(nshares, nshares, y);
+}
+
+// B = A_0, then B = B + A_i for i = 1 .. nshares - 1, one lookup per chunk: index = chunk of B | carry << A2B_TABLE_BITS
+void A2B_table(size_t nshares, size_t nbits, uint32_t B[nshares], const uint32_t A[nshares])
+{
+    uint32_t S[LUT_ROWS];
+    uint32_t x[nshares], y[nshares], carry[nshares];
+
+    B[0] = A[0] & (uint32_t)((1ull << nbits) - 1);
+
+    for (size_t j = 1; j < nshares; j++)
+    {
+        B[j] = 0;
+    }
+
+    for (size_t i = 1; i < nshares; i++)
+    {
+        for (size_t j = 0; j < nshares; j++)
+        {
+            carry[j] = 0;
+        }
+
+        for (size_t off = 0; off < nbits; off += A2B_TABLE_BITS)
+        {
+            size_t k = (nbits - off < A2B_TABLE_BITS) ? nbits - off : A2B_TABLE_BITS;
+            uint32_t chunk_mask = (1u << k) - 1;
+            uint32_t a = (A[i] >> off) & chunk_mask;
+
+            // the sum chunk in the low k bits, the carry out at bit A2B_TABLE_BITS
+            for (uint32_t u = 0; u < LUT_ROWS; u++)
+            {
+                uint32_t sum = (u & chunk_mask) + a + (u >> A2B_TABLE_BITS);
+
+                S[u] = (sum & chunk_mask) | (sum >> k) << A2B_TABLE_BITS;
+            }
+
+            for (size_t j = 0; j < nshares; j++)
+            {
+                x[j] = ((B[j] >> off) & chunk_mask) | carry[j] << A2B_TABLE_BITS;
+            }
+
+            SecLUT(nshares, y, x, S);
+
+            for (size_t j = 0; j < nshares; j++)
+            {
+                B[j] = (B[j] & ~(chunk_mask << off)) | (y[j] & chunk_mask) << off;
+                carry[j] = (y[j] >> A2B_TABLE_BITS) & 1;
+            }
+        }
+    }
+
+#ifdef DEBUG
+    uint32_t A_unmasked = 0;
+    uint32_t B_unmasked = 0;
+
+    for (size_t j = 0; j < nshares; j++)
+    {
+        A_unmasked = A_unmasked + A[j];
+        B_unmasked = B_unmasked ^ B[j];
+    }
+
+    assert((A_unmasked & (uint32_t)((1ull << nbits) - 1)) == B_unmasked);
+#endif
+}
+
+// number of 32-bit random words drawn per call
+size_t A2B_table_rand_words(size_t nshares, size_t nbits)
+{
+    size_t chunks = (nbits + A2B_TABLE_BITS - 1) / A2B_TABLE_BITS;
+    size_t lut = (nshares - 1) * LUT_ROUND_WORDS(nshares) + RefreshXOR32_rand_words(nshares);
+
+    return (nshares - 1) * chunks * lut;
+}
@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef A2BTABLE_H
+#define A2BTABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef DEBUG
+#include <stdio.h>
+#include <assert.h>
+#endif
+
+/*
+* Table-based higher-order A2B for narrow widths: the arithmetic shares are added one by one to a Boolean-masked
+* accumulator, A2B_TABLE_BITS bits at a time with a masked carry. Each chunk is one masked lookup in a table of
+* 2^(A2B_TABLE_BITS + 1) rows, recomputed under the shares of the index [Coron, EUROCRYPT 2014, Algorithm 3].
+* A2B_TABLE selects this engine in A2B_keepbitsliced (MaskedComparison_Simple, _GF and _HybridSimple).
+*/
+#ifndef A2B_TABLE_BITS
+    #define A2B_TABLE_BITS 2
+#endif
+
+#if A2B_TABLE_BITS < 1 || A2B_TABLE_BITS > 7
+    #error "A2B_TABLE_BITS: the lookup index of A2B_TABLE_BITS + 1 bits must fit in a byte"
+#endif
+
+void A2B_table(size_t nshares, size_t nbits, uint32_t B[nshares], const uint32_t A[nshares]);
+
+size_t A2B_table_rand_words(size_t nshares, size_t nbits);
+
+#endif // A2BTABLE_H
@@ -30,12 +30,16 @@ static uint64_t addop(uint64_t a[], size_t n)
 
 static void refresh(uint64_t a[], size_t n)
 {
+	PROFILE_RAND_GADGET(RNG_GADGET_B2A_REFRESH);
+
 	for (size_t i = 1; i < n; i++)
 	{
 		uint64_t tmp = random_uint64();
 		a[0] = a[0] ^ tmp;
 		a[i] = a[i] ^ tmp;
 	}
+
+	PROFILE_RAND_GADGET_END();
 }
 
 static uint64_t Psi(uint64_t x, uint64_t y)
@@ -54,67 +58,199 @@ static void copy(uint64_t *x, uint64_t *y, size_t n)
 		x[i] = y[i];
 }
 
-// here, x contains n+1 shares
-static void impconvBA_rec(uint64_t *D, uint64_t *x, size_t n)
+// here, x contains 3 shares
+static void impconvBA_2(uint64_t *D, uint64_t *x)
 {
-	if (n == 2)
-	{
-		uint64_t r1 = random_uint64();
-		uint64_t r2 = random_uint64();
-		uint64_t y0 = (x[0] ^ r1) ^ r2;
-		uint64_t y1 = x[1] ^ r1;
-		uint64_t y2 = x[2] ^ r2;
+	PROFILE_RAND_GADGET(RNG_GADGET_B2A);
 
-		uint64_t z0 = y0 ^ Psi(y0, y1);
-		uint64_t z1 = Psi(y0, y2);
+	uint64_t r1 = random_uint64();
+	uint64_t r2 = random_uint64();
+	uint64_t y0 = (x[0] ^ r1) ^ r2;
+	uint64_t y1 = x[1] ^ r1;
+	uint64_t y2 = x[2] ^ r2;
 
-		D[0] = y1 ^ y2;
-		D[1] = z0 ^ z1;
+	uint64_t z0 = y0 ^ Psi(y0, y1);
+	uint64_t z1 = Psi(y0, y2);
+
+	D[0] = y1 ^ y2;
+	D[1] = z0 ^ z1;
 
 #ifdef DEBUG
-		assert((x[0] ^ x[1] ^ x[2]) == (D[0] + D[1]));
+	assert((x[0] ^ x[1] ^ x[2]) == (D[0] + D[1]));
 #endif
 
+	PROFILE_RAND_GADGET_END();
+}
+
+/*
+* The recursion of [TCHES 2019, impconvBA] on n = nshares .. 3, run depth-first without recursing: level n keeps its
+* frame y[n + 1], z[n], A[n - 1], B[n - 1] in the workspace and a stage (0: convert y + 1 into A, 1: convert z into B,
+* 2: merge A and B into D), so the random words are drawn in the order of the recursive version. B2A_FRAME_WORDS is in B2A.h.
+*/
+
+// here, x contains nshares+1 shares
+static void impconvBA(uint64_t *D, uint64_t *x, size_t nshares, uint64_t *workspace)
+{
+	uint64_t *frame[NSHARES + 1], *in[NSHARES + 1], *out[NSHARES + 1];
+	int stage[NSHARES + 1];
+
+	if (nshares == 2)
+	{
+		impconvBA_2(D, x);
 		return;
 	}
 
-	uint64_t y[n + 1];
-	copy(y, x, n + 1);
+	for (size_t n = 3; n <= nshares; n++)
+	{
+		frame[n] = workspace;
+		workspace += B2A_FRAME_WORDS(n);
+	}
 
-	refresh(y, n + 1);
+	size_t n = nshares;
+	in[n] = x;
+	out[n] = D;
+	stage[n] = 0;
 
-	uint64_t z[n];
+	while (1)
+	{
+		uint64_t *y = frame[n];
+		uint64_t *z = y + n + 1;
+		uint64_t *A = z + n;
+		uint64_t *B = A + n - 1;
 
-	z[0] = Psi0(y[0], y[1], n);
-	for (size_t i = 1; i < n; i++)
-		z[i] = Psi(y[0], y[i + 1]);
+		if (stage[n] == 0)
+		{
+			copy(y, in[n], n + 1);
+
+			refresh(y, n + 1);
+
+			z[0] = Psi0(y[0], y[1], n);
+			for (size_t i = 1; i < n; i++)
+				z[i] = Psi(y[0], y[i + 1]);
 
 #ifdef DEBUG
-	assert(xorop(x, n + 1) == (xorop(y + 1, n) + xorop(z, n)));
+			assert(xorop(in[n], n + 1) == (xorop(y + 1, n) + xorop(z, n)));
 #endif
+		}
+
+		if (stage[n] < 2)
+		{
+			uint64_t *child_in = (stage[n] == 0) ? y + 1 : z;
+			uint64_t *child_out = (stage[n] == 0) ? A : B;
+
+			stage[n]++;
 
-	uint64_t A[n - 1], B[n - 1];
-	impconvBA_rec(A, y + 1, n - 1);
-	impconvBA_rec(B, z, n - 1);
+			if (n == 3)
+			{
+				impconvBA_2(child_out, child_in);
+			}
+			else
+			{
+				n--;
+				in[n] = child_in;
+				out[n] = child_out;
+				stage[n] = 0;
+			}
+			continue;
+		}
 
-	for (size_t i = 0; i < n - 2; i++)
-		D[i] = A[i] + B[i];
+		for (size_t i = 0; i < n - 2; i++)
+			out[n][i] = A[i] + B[i];
 
-	D[n - 2] = A[n - 2];
-	D[n - 1] = B[n - 2];
+		out[n][n - 2] = A[n - 2];
+		out[n][n - 1] = B[n - 2];
 
 #ifdef DEBUG
-	assert(xorop(x, n + 1) == addop(D, n));
+		assert(xorop(in[n], n + 1) == addop(out[n], n));
 #endif
+
+		if (n == nshares)
+			break;
+		n++;
+	}
 }
 
-void B2A(uint64_t A[NSHARES], uint32_t B[NSHARES])
+void B2A(uint64_t A[NSHARES], uint32_t B[NSHARES], uint64_t workspace[])
 {
-	uint64_t B_ext[NSHARES + 1];
+	uint64_t *B_ext = workspace;
 	for (size_t i = 0; i < NSHARES; i++)
 	{
 		B_ext[i] = B[i];
 	}
 	B_ext[NSHARES] = 0;
-	impconvBA_rec(A, B_ext, NSHARES);
+	impconvBA(A, B_ext, NSHARES, &workspace[NSHARES + 1]);
+}
+
+void B2A_batch(size_t count, uint64_t A[count][NSHARES], const uint32_t B[count][NSHARES], uint64_t workspace[])
+{
+	size_t i = 0;
+	uint32_t Bi[NSHARES];
+
+#ifdef B2A_SIMD
+	if (B2A_simd_available())
+	{
+		i = count - count % B2A_SIMD_WIDTH;
+		B2A_avx2(i, A, B, workspace);
+	}
+#endif
+
+	// the remainder, or all coefficients without simd
+	for (; i < count; i++)
+	{
+		for (size_t j = 0; j < NSHARES; j++)
+			Bi[j] = B[i][j];
+		B2A(A[i], Bi, workspace);
+	}
+
+#ifdef DEBUG
+	for (i = 0; i < count; i++)
+	{
+		uint64_t x = 0;
+
+		for (size_t j = 0; j < NSHARES; j++)
+			x ^= B[i][j];
+
+		assert(x == addop(A[i], NSHARES));
+	}
+#endif
+}
+
+// in 64-bit words: the extended input and one frame per level
+size_t B2A_workspace_size(void)
+{
+	size_t words = NSHARES + 1;
+
+	for (size_t n = 3; n <= NSHARES; n++)
+	{
+		words += B2A_FRAME_WORDS(n);
+	}
+
+	return words;
+}
+
+static size_t impconvBA_rand_words(size_t n)
+{
+	if (n == 2)
+	{
+		return 2 * 2;
+	}
+
+	// refresh draws n words of 64 bits
+	return 2 * n + 2 * impconvBA_rand_words(n - 1);
+}
+
+// in 64-bit words: the workspace of B2A, or B2A_SIMD_WIDTH times the input, output, random words and frames of B2A_avx2
+size_t B2A_batch_workspace_size(void)
+{
+#ifdef B2A_SIMD
+	return B2A_SIMD_WIDTH * (B2A_workspace_size() + NSHARES + B2A_rand_words() / 2);
+#else
+	return B2A_workspace_size();
+#endif
+}
+
+// number of 32-bit random words drawn per call
+size_t B2A_rand_words()
+{
+	return impconvBA_rand_words(NSHARES);
 }
\ No newline at end of file
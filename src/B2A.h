@@ -36,6 +36,31 @@
 #include <assert.h>
 #endif
 
-void B2A(uint64_t A[NSHARES], uint32_t B[NSHARES]);
+// workspace: B2A_workspace_size() words, allocated once by the caller and reused for every coefficient
+void B2A(uint64_t A[NSHARES], uint32_t B[NSHARES], uint64_t workspace[]);
+
+size_t B2A_rand_words(void);
+size_t B2A_workspace_size(void);
+
+// count coefficients, vectorized across coefficients where B2A_SIMD is available, with B2A_batch_workspace_size() words
+void B2A_batch(size_t count, uint64_t A[count][NSHARES], const uint32_t B[count][NSHARES], uint64_t workspace[]);
+size_t B2A_batch_workspace_size(void);
+
+// words of the frame of one level of the impconvBA recursion (B2A.c)
+#define B2A_FRAME_WORDS(n) (4 * (n) - 1)
+
+// x86-64 host: B2A of B2A_SIMD_WIDTH coefficients per AVX2 vector of 64-bit lanes (B2A_simd.c)
+#if defined(__x86_64__) && !defined(B2A_NO_SIMD)
+
+    #define B2A_SIMD
+    #define B2A_SIMD_WIDTH 4
+
+    void B2A_avx2(size_t count, uint64_t A[count][NSHARES], const uint32_t B[count][NSHARES], uint64_t workspace[]);
+
+    static inline int B2A_simd_available(void)
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
 
 #endif // B2A_H
\ No newline at end of file
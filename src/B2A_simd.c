@@ -0,0 +1,177 @@
+// [https://tches.iacr.org/index.php/TCHES/article/view/873/825]
+// [https://pastebin.com/WKnNyEU8]
+
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License version 2 as published
+// by the Free Software Foundation.
+
+#include "B2A.h"
+#include "randombytes.h"
+
+#ifdef B2A_SIMD
+
+/*
+* The impconvBA recursion of B2A.c on B2A_SIMD_WIDTH coefficients at once: every 64-bit word becomes a vector with one
+* coefficient per lane, and every random word a vector of independent words, so each lane runs the scalar B2A.
+* The vectors live in the caller's uint64_t workspace, hence the 8-byte alignment.
+*/
+typedef uint64_t b2a_vec __attribute__((vector_size(8 * B2A_SIMD_WIDTH), aligned(8)));
+
+__attribute__((target("avx2")))
+static inline b2a_vec Psi_avx2(b2a_vec x, b2a_vec y)
+{
+	return (x ^ y) - y;
+}
+
+__attribute__((target("avx2")))
+static inline b2a_vec Psi0_avx2(b2a_vec x, b2a_vec y, size_t n)
+{
+	return Psi_avx2(x, y) ^ ((~n & 1) * x);
+}
+
+__attribute__((target("avx2")))
+static void refresh_avx2(b2a_vec a[], size_t n, const b2a_vec **R)
+{
+	for (size_t i = 1; i < n; i++)
+	{
+		b2a_vec tmp = *(*R)++;
+		a[0] = a[0] ^ tmp;
+		a[i] = a[i] ^ tmp;
+	}
+}
+
+// here, x contains 3 shares
+__attribute__((target("avx2")))
+static void impconvBA_2_avx2(b2a_vec *D, const b2a_vec *x, const b2a_vec **R)
+{
+	b2a_vec r1 = *(*R)++;
+	b2a_vec r2 = *(*R)++;
+	b2a_vec y0 = (x[0] ^ r1) ^ r2;
+	b2a_vec y1 = x[1] ^ r1;
+	b2a_vec y2 = x[2] ^ r2;
+
+	b2a_vec z0 = y0 ^ Psi_avx2(y0, y1);
+	b2a_vec z1 = Psi_avx2(y0, y2);
+
+	D[0] = y1 ^ y2;
+	D[1] = z0 ^ z1;
+}
+
+// impconvBA of B2A.c, with the frames of level n = 3 .. nshares in workspace and the random vectors read from R
+__attribute__((target("avx2")))
+static void impconvBA_avx2(b2a_vec *D, b2a_vec *x, size_t nshares, b2a_vec *workspace, const b2a_vec *R)
+{
+	b2a_vec *frame[NSHARES + 1], *in[NSHARES + 1], *out[NSHARES + 1];
+	int stage[NSHARES + 1];
+
+	if (nshares == 2)
+	{
+		impconvBA_2_avx2(D, x, &R);
+		return;
+	}
+
+	for (size_t n = 3; n <= nshares; n++)
+	{
+		frame[n] = workspace;
+		workspace += B2A_FRAME_WORDS(n);
+	}
+
+	size_t n = nshares;
+	in[n] = x;
+	out[n] = D;
+	stage[n] = 0;
+
+	while (1)
+	{
+		b2a_vec *y = frame[n];
+		b2a_vec *z = y + n + 1;
+		b2a_vec *A = z + n;
+		b2a_vec *B = A + n - 1;
+
+		if (stage[n] == 0)
+		{
+			for (size_t i = 0; i < n + 1; i++)
+				y[i] = in[n][i];
+
+			refresh_avx2(y, n + 1, &R);
+
+			z[0] = Psi0_avx2(y[0], y[1], n);
+			for (size_t i = 1; i < n; i++)
+				z[i] = Psi_avx2(y[0], y[i + 1]);
+		}
+
+		if (stage[n] < 2)
+		{
+			b2a_vec *child_in = (stage[n] == 0) ? y + 1 : z;
+			b2a_vec *child_out = (stage[n] == 0) ? A : B;
+
+			stage[n]++;
+
+			if (n == 3)
+			{
+				impconvBA_2_avx2(child_out, child_in, &R);
+			}
+			else
+			{
+				n--;
+				in[n] = child_in;
+				out[n] = child_out;
+				stage[n] = 0;
+			}
+			continue;
+		}
+
+		for (size_t i = 0; i < n - 2; i++)
+			out[n][i] = A[i] + B[i];
+
+		out[n][n - 2] = A[n - 2];
+		out[n][n - 1] = B[n - 2];
+
+		if (n == nshares)
+			break;
+		n++;
+	}
+}
+
+/*
+* count must be a multiple of B2A_SIMD_WIDTH. The random words of a group are drawn in one bulk request:
+* word k of coefficient g is 64-bit word B2A_SIMD_WIDTH * k + g, so a group draws as many words as B2A_SIMD_WIDTH B2A calls.
+*/
+__attribute__((target("avx2")))
+void B2A_avx2(size_t count, uint64_t A[count][NSHARES], const uint32_t B[count][NSHARES], uint64_t workspace[])
+{
+	size_t nrand = B2A_rand_words() / 2;
+	b2a_vec *x = (b2a_vec *)workspace;
+	b2a_vec *D = x + NSHARES + 1;
+	b2a_vec *R = D + NSHARES;
+	b2a_vec *frames = R + nrand;
+
+	for (size_t i = 0; i < count; i += B2A_SIMD_WIDTH)
+	{
+		for (size_t j = 0; j < NSHARES; j++)
+		{
+			for (size_t g = 0; g < B2A_SIMD_WIDTH; g++)
+			{
+				x[j][g] = B[i + g][j];
+			}
+		}
+		x[NSHARES] = (b2a_vec){0};
+
+		PROFILE_RAND_GADGET(RNG_GADGET_B2A);
+		random_uint64_n((uint64_t *)R, B2A_SIMD_WIDTH * nrand);
+
+		impconvBA_avx2(D, x, NSHARES, frames, R);
+
+		for (size_t j = 0; j < NSHARES; j++)
+		{
+			for (size_t g = 0; g < B2A_SIMD_WIDTH; g++)
+			{
+				A[i + g][j] = D[j][g];
+			}
+		}
+
+		PROFILE_RAND_GADGET_END();
+	}
+}
+
+#endif
@@ -28,28 +28,41 @@
 #include "SecAnd.h"
 #include "A2B.h"
 
-uint32_t BooleanEqualityTest(uint64_t E[NSHARES])
+#ifndef NBS_GROUP
+    #define NBS_GROUP 8 // coefficients whose bits are AND-reduced together in BooleanEqualityTest_Simple_NBS
+#endif
+
+// AND all len registers in a balanced tree, the result ends up in B[0]: still len - 1 SecAND's, but each level is one batch
+#define SECAND_TREE(W, T)                                                                                                       \
+    static void SecAND##W##_tree(size_t len, T B[len][NSHARES])                                                                 \
+    {                                                                                                                           \
+        while (len > 1)                                                                                                         \
+        {                                                                                                                       \
+            size_t half = len / 2;                                                                                              \
+                                                                                                                                \
+            SecAND##W##_batch(NSHARES, half, B, B, B + half);                                                                   \
+                                                                                                                                \
+            if (len & 1)                                                                                                        \
+            {                                                                                                                   \
+                for (size_t k = 0; k < NSHARES; k++)                                                                            \
+                {                                                                                                               \
+                    B[half][k] = B[len - 1][k];                                                                                 \
+                }                                                                                                               \
+            }                                                                                                                   \
+                                                                                                                                \
+            len = half + (len & 1);                                                                                             \
+        }                                                                                                                       \
+    }
+
+SECAND_TREE(32, uint32_t)
+SECAND_TREE(L, lane_t)
+
+// AND the bits of a 32-bit register by halving it 5 times, and unmask: the result is in bit 0
+static uint32_t SecAND32_fold(uint32_t out[NSHARES])
 {
-    uint64_t B[NSHARES];
     uint32_t Bh[NSHARES], Bl[NSHARES];
-    uint32_t out[NSHARES];
     uint32_t out_unmasked = 0;
 
-    A2B(NSHARES, B, E);
-
-    // Boolean equality circuit: B = 0 -> ~B[63] AND ~B[62] AND ... ~B[0];
-
-    // ~B
-    B[0] ^= 0xffffffffffffffff;
-
-    for (size_t i = 0; i < NSHARES; i++)
-    {
-        Bl[i] = B[i];
-        Bh[i] = B[i] >> 32;
-    }
-
-    SecAND32(NSHARES, out, Bh, Bl);
-
     for(size_t j = 16; j > 0; j >>= 1)
     {
         for (size_t i = 0; i < NSHARES; i++)
@@ -61,7 +74,7 @@ uint32_t BooleanEqualityTest(uint64_t E[NSHARES])
         SecAND32(NSHARES, out, Bh, Bl);
     }
 
-    for (size_t i = 0; i < NSHARES; i++)
+    for (size_t i = 0; i <  NSHARES; i++)
     {
         out_unmasked ^= out[i];
     }
@@ -69,31 +82,53 @@ uint32_t BooleanEqualityTest(uint64_t E[NSHARES])
     return out_unmasked;
 }
 
-uint32_t BooleanEqualityTest_GF(struct uint96_t B)
+// AND the lowest nbits bits of the coefficients first..first+count into out, NBS_GROUP coefficients per tree
+static void SecAND32_bits(uint32_t out[NSHARES], uint32_t B[][NSHARES], size_t first, size_t count, size_t nbits)
 {
-    // uint64_t B[NSHARES];
+    uint32_t tmp[NBS_GROUP * nbits][NSHARES];
+
+    for (size_t i = first; i < first + count; i += NBS_GROUP)
+    {
+        size_t len = 0;
+
+        for (size_t c = i; c < i + NBS_GROUP && c < first + count; c++)
+        {
+            for (size_t j = 0; j < nbits; j++)
+            {
+                for (size_t k = 0; k < NSHARES; k++)
+                {
+                    tmp[len][k] = B[c][k] >> j;
+                }
+                len++;
+            }
+        }
+
+        SecAND32_tree(len, tmp);
+        SecAND32(NSHARES, out, out, tmp[0]);
+    }
+}
+
+uint32_t BooleanEqualityTest(uint64_t E[NSHARES])
+{
+    uint64_t B[NSHARES];
     uint32_t Bh[NSHARES], Bl[NSHARES];
-    uint32_t tmp[NSHARES];
     uint32_t out[NSHARES];
     uint32_t out_unmasked = 0;
 
-    // A2B(NSHARES, B, E);
+    A2B(NSHARES, B, E);
 
     // Boolean equality circuit: B = 0 -> ~B[63] AND ~B[62] AND ... ~B[0];
 
     // ~B
-    B.LSB[0] ^= 0xffffffffffffffff;
-    B.MSB[0] ^= 0xffffffff;
+    B[0] ^= 0xffffffffffffffff;
 
     for (size_t i = 0; i < NSHARES; i++)
     {
-        Bl[i] = B.LSB[i];
-        Bh[i] = B.LSB[i] >> 32;
+        Bl[i] = B[i];
+        Bh[i] = B[i] >> 32;
     }
 
-    SecAND32(NSHARES, tmp, Bh, Bl);
-    SecAND32(NSHARES, out, tmp, B.MSB);
-
+    SecAND32(NSHARES, out, Bh, Bl);
 
     for(size_t j = 16; j > 0; j >>= 1)
     {
@@ -114,55 +149,52 @@ uint32_t BooleanEqualityTest_GF(struct uint96_t B)
     return out_unmasked;
 }
 
-uint32_t BooleanEqualityTest_Simple(uint32_t B[SIMPLECOMPBITS][NSHARES], uint32_t len)
+uint32_t BooleanEqualityTest_Simple(lane_t B[SIMPLECOMPBITS][NSHARES], uint32_t len)
 {
-    // uint64_t B[NSHARES];
-    uint32_t Bh[NSHARES], Bl[NSHARES];
-    uint32_t out[NSHARES];
-    uint32_t out_unmasked = 0;
+    uint32_t out[LANE_WORDS][NSHARES];
 
     // ~B
     for (size_t i = 0; i < len; i++)
     {
-        B[i][0] ^= 0xffffffffffffffff;
+        B[i][0] = ~B[i][0];
     }
 
     // AND all different registers for 0 to len
-    SecAND32(NSHARES, out, B[0], B[1]);
+    SecANDL_tree(len, B);
 
-    for (size_t i = 2; i < len; i++)
+    // AND the 32-bit words of the lane
+    for (size_t w = 0; w < LANE_WORDS; w++)
     {
         for (size_t j = 0; j < NSHARES; j++)
         {
-            Bh[j] = out[j];
+            out[w][j] = lane_word(&B[0][j], w);
         }
-        SecAND32(NSHARES, out, Bh, B[i]);
     }
-    
-    // do within register AND's
-    for(size_t j = 16; j > 0; j >>= 1)
-    {
-        for (size_t i = 0; i < NSHARES; i++)
-        {
-            Bl[i] = (out[i]) & ((1 << j) - 1);
-            Bh[i] = (out[i] >> j) & ((1 << j) - 1);
-        }
 
-        SecAND32(NSHARES, out, Bh, Bl);
-    }
+    SecAND32_tree(LANE_WORDS, out);
 
-    for (size_t i = 0; i <  NSHARES; i++)
+    // do within register AND's
+    return SecAND32_fold(out[0]);
+}
+
+uint32_t BooleanEqualityTest_Simple32(uint32_t B[][NSHARES], uint32_t len)
+{
+    // ~B
+    for (size_t i = 0; i < len; i++)
     {
-        out_unmasked ^= out[i];
+        B[i][0] ^= 0xffffffffffffffff;
     }
 
-    return out_unmasked;
+    // AND all different registers for 0 to len
+    SecAND32_tree(len, B);
+
+    // do within register AND's
+    return SecAND32_fold(B[0]);
 }
 
 uint32_t BooleanEqualityTest_Simple_NBS(uint32_t B[][NSHARES], uint32_t len)
 {
     // uint64_t B[NSHARES];
-    uint32_t tmp[NSHARES];
     uint32_t out[NSHARES];
     uint32_t out_unmasked = 0;
 
@@ -178,29 +210,8 @@ uint32_t BooleanEqualityTest_Simple_NBS(uint32_t B[][NSHARES], uint32_t len)
         out[j] = 0;
     }
 
-    for (size_t i = 0; i < NCOEFFS_B; i++)
-    {
-        for (size_t j = 0; j < COMPRESSTO_B; j++)
-        {
-            for (size_t k = 0; k < NSHARES; k++)
-            {
-                tmp[k] = B[i][k] >> j;
-            }
-            SecAND32(NSHARES, out, out, tmp);
-        }
-    }
-
-    for (size_t i = NCOEFFS_B; i < NCOEFFS_B + NCOEFFS_C; i++)
-    {
-        for (size_t j = 0; j < COMPRESSTO_C; j++)
-        {
-            for (size_t k = 0; k < NSHARES; k++)
-            {
-                tmp[k] = B[i][k] >> j;
-            }
-            SecAND32(NSHARES, out, out, tmp);
-        }
-    }
+    SecAND32_bits(out, B, 0, NCOEFFS_B, COMPRESSTO_B);
+    SecAND32_bits(out, B, NCOEFFS_B, NCOEFFS_C, COMPRESSTO_C);
 
     for (size_t i = 0; i <  NSHARES; i++)
     {
@@ -210,4 +221,25 @@ uint32_t BooleanEqualityTest_Simple_NBS(uint32_t B[][NSHARES], uint32_t len)
     out_unmasked = out_unmasked & 1;
 
     return out_unmasked;
-}
\ No newline at end of file
+}
+
+// number of 32-bit random words drawn per call, the within-register AND's take 5 SecAND's
+size_t BooleanEqualityTest_rand_words()
+{
+    return A2B_rand_words(NSHARES) + (1 + 5) * SecAND32_rand_words(NSHARES);
+}
+
+size_t BooleanEqualityTest_Simple_rand_words(uint32_t len)
+{
+    return (len - 1) * SecANDL_rand_words(NSHARES) + (LANE_WORDS - 1 + 5) * SecAND32_rand_words(NSHARES);
+}
+
+size_t BooleanEqualityTest_Simple32_rand_words(uint32_t len)
+{
+    return (len - 1 + 5) * SecAND32_rand_words(NSHARES);
+}
+
+size_t BooleanEqualityTest_Simple_NBS_rand_words()
+{
+    return (NCOEFFS_B * COMPRESSTO_B + NCOEFFS_C * COMPRESSTO_C) * SecAND32_rand_words(NSHARES);
+}
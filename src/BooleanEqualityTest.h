@@ -30,6 +30,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "params.h"
+#include "Lane.h"
 #include "ReduceComparisons.h"
 
 #ifdef DEBUG
@@ -39,11 +40,16 @@
 
 uint32_t BooleanEqualityTest(uint64_t E[NSHARES]);
 
-uint32_t BooleanEqualityTest_GF(struct uint96_t B);
-
-uint32_t BooleanEqualityTest_Simple(uint32_t B[SIMPLECOMPBITS][NSHARES], uint32_t len);
+// bitsliced registers of LANE_BITS coefficients, and 32-bit registers of one coefficient each
+uint32_t BooleanEqualityTest_Simple(lane_t B[SIMPLECOMPBITS][NSHARES], uint32_t len);
+uint32_t BooleanEqualityTest_Simple32(uint32_t B[][NSHARES], uint32_t len);
 
 uint32_t BooleanEqualityTest_Simple_NBS(uint32_t B[SIMPLECOMPBITS][NSHARES], uint32_t len);
 
+size_t BooleanEqualityTest_rand_words(void);
+size_t BooleanEqualityTest_Simple_rand_words(uint32_t len);
+size_t BooleanEqualityTest_Simple32_rand_words(uint32_t len);
+size_t BooleanEqualityTest_Simple_NBS_rand_words(void);
+
 
 #endif // BOOLEANEQUALITYTEST_H
\ No newline at end of file
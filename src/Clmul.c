@@ -0,0 +1,202 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Clmul.h"
+
+#ifdef DEBUG
+#include <assert.h>
+#endif
+
+#ifdef CLMUL_SIMD
+
+#include <immintrin.h>
+
+__attribute__((target("pclmul")))
+static void clmul64x32_xor_pclmul(size_t n, uint64_t lo[n], uint32_t hi[n], uint64_t a, const uint32_t b[n])
+{
+    __m128i va = _mm_cvtsi64_si128((long long)a);
+
+    for (size_t j = 0; j < n; j++)
+    {
+        __m128i p = _mm_clmulepi64_si128(va, _mm_cvtsi32_si128((int)b[j]), 0x00);
+
+        lo[j] ^= (uint64_t)_mm_cvtsi128_si64(p);
+        hi[j] ^= (uint32_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+    }
+}
+
+__attribute__((target("pclmul")))
+static void clmul64_pclmul(uint64_t *lo, uint64_t *hi, uint64_t a, uint64_t b)
+{
+    __m128i p = _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long)a), _mm_cvtsi64_si128((long long)b), 0x00);
+
+    *lo = (uint64_t)_mm_cvtsi128_si64(p);
+    *hi = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+}
+
+#endif
+
+#ifndef CLMUL_NAIVE
+// carry-less 32 x 32 -> 64-bit product: every fourth bit of x and y, so the at most 8 terms per result bit fit in its 4-bit hole
+static inline uint64_t bmul32(uint32_t x, uint32_t y)
+{
+    uint64_t x0 = x & 0x11111111, x1 = x & 0x22222222, x2 = x & 0x44444444, x3 = x & 0x88888888;
+    uint64_t y0 = y & 0x11111111, y1 = y & 0x22222222, y2 = y & 0x44444444, y3 = y & 0x88888888;
+
+    uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+
+    return (z0 & 0x1111111111111111) | (z1 & 0x2222222222222222) | (z2 & 0x4444444444444444) | (z3 & 0x8888888888888888);
+}
+#endif
+
+#if defined(CLMUL_NAIVE) || defined(DEBUG)
+// bit k of b selects a << k, the bits shifted out of lo go to hi
+static void clmul64x32_naive(uint64_t *lo, uint32_t *hi, uint64_t a, uint32_t b)
+{
+    uint64_t l = 0;
+    uint32_t h = 0;
+
+    for (size_t k = 0; k < 32; k++)
+    {
+        uint64_t tmp = a * ((b >> k) & 1);
+
+        l ^= tmp << k;
+        if (k > 0)
+        {
+            h ^= (uint32_t)(tmp >> (64 - k));
+        }
+    }
+
+    *lo = l;
+    *hi = h;
+}
+#endif
+
+static void clmul64x32_xor_portable(size_t n, uint64_t lo[n], uint32_t hi[n], uint64_t a, const uint32_t b[n])
+{
+    for (size_t j = 0; j < n; j++)
+    {
+    #ifdef CLMUL_NAIVE
+        uint64_t l;
+        uint32_t h;
+
+        clmul64x32_naive(&l, &h, a, b[j]);
+        lo[j] ^= l;
+        hi[j] ^= h;
+    #else
+        uint64_t p0 = bmul32((uint32_t)a, b[j]);
+        uint64_t p1 = bmul32((uint32_t)(a >> 32), b[j]);
+
+        lo[j] ^= p0 ^ (p1 << 32);
+        hi[j] ^= (uint32_t)(p1 >> 32);
+    #endif
+    }
+}
+
+void clmul64x32_xor(size_t n, uint64_t lo[n], uint32_t hi[n], uint64_t a, const uint32_t b[n])
+{
+#ifdef DEBUG
+    uint64_t lo_ref[n];
+    uint32_t hi_ref[n];
+
+    for (size_t j = 0; j < n; j++)
+    {
+        clmul64x32_naive(&lo_ref[j], &hi_ref[j], a, b[j]);
+        lo_ref[j] ^= lo[j];
+        hi_ref[j] ^= hi[j];
+    }
+#endif
+
+#if defined(CLMUL_SIMD)
+    if (__builtin_cpu_supports("pclmul"))
+    {
+        clmul64x32_xor_pclmul(n, lo, hi, a, b);
+    }
+    else
+    {
+        clmul64x32_xor_portable(n, lo, hi, a, b);
+    }
+#else
+    clmul64x32_xor_portable(n, lo, hi, a, b);
+#endif
+
+#ifdef DEBUG
+    for (size_t j = 0; j < n; j++)
+    {
+        assert(lo[j] == lo_ref[j] && hi[j] == hi_ref[j]);
+    }
+#endif
+}
+
+static void clmul64_portable(uint64_t *lo, uint64_t *hi, uint64_t a, uint64_t b)
+{
+#ifdef CLMUL_NAIVE
+    uint64_t l0, l1;
+    uint32_t h0, h1;
+
+    clmul64x32_naive(&l0, &h0, a, (uint32_t)b);
+    clmul64x32_naive(&l1, &h1, a, (uint32_t)(b >> 32));
+
+    *lo = l0 ^ (l1 << 32);
+    *hi = h0 ^ (l1 >> 32) ^ ((uint64_t)h1 << 32);
+#else
+    uint64_t p00 = bmul32((uint32_t)a, (uint32_t)b);
+    uint64_t p11 = bmul32((uint32_t)(a >> 32), (uint32_t)(b >> 32));
+    uint64_t pm = bmul32((uint32_t)a, (uint32_t)(b >> 32)) ^ bmul32((uint32_t)(a >> 32), (uint32_t)b);
+
+    *lo = p00 ^ (pm << 32);
+    *hi = p11 ^ (pm >> 32);
+#endif
+}
+
+void clmul64(uint64_t *lo, uint64_t *hi, uint64_t a, uint64_t b)
+{
+#if defined(CLMUL_SIMD)
+    if (__builtin_cpu_supports("pclmul"))
+    {
+        clmul64_pclmul(lo, hi, a, b);
+    }
+    else
+    {
+        clmul64_portable(lo, hi, a, b);
+    }
+#else
+    clmul64_portable(lo, hi, a, b);
+#endif
+
+#ifdef DEBUG
+    uint64_t l0, l1;
+    uint32_t h0, h1;
+
+    clmul64x32_naive(&l0, &h0, a, (uint32_t)b);
+    clmul64x32_naive(&l1, &h1, a, (uint32_t)(b >> 32));
+
+    assert(*lo == (l0 ^ (l1 << 32)) && *hi == (h0 ^ (l1 >> 32) ^ ((uint64_t)h1 << 32)));
+#endif
+}
@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CLMUL_H
+#define CLMUL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) && !defined(CLMUL_NO_SIMD) && !defined(CLMUL_NAIVE)
+    #define CLMUL_SIMD
+    #define CLMUL_VARIANT "pclmulqdq"
+#elif defined(CLMUL_NAIVE)
+    #define CLMUL_VARIANT "naive"
+#else
+    #define CLMUL_VARIANT "bmul"
+#endif
+
+/*
+* Carry-less (GF(2)[x]) products for ReduceComparisons_GF: lo[j], hi[j] ^= the 95-bit product of a and b[j], for j < n.
+* On x86-64 hosts with PCLMULQDQ one instruction per product, unless CLMUL_NO_SIMD.
+* Otherwise integer multiplications of operands with 3-bit holes [BearSSL, ghash_ctmul.c]: constant-time as long as
+* the multiplier is (true for the Cortex-M4 UMULL, not for Cortex-M3). CLMUL_NAIVE keeps the bit-by-bit loop.
+*/
+void clmul64x32_xor(size_t n, uint64_t lo[n], uint32_t hi[n], uint64_t a, const uint32_t b[n]);
+
+// the 127-bit product of a and b, for the field multiplications of ReduceComparisons_GF_polyeval
+void clmul64(uint64_t *lo, uint64_t *hi, uint64_t a, uint64_t b);
+
+#endif // CLMUL_H
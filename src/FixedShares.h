@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FIXEDSHARES_H
+#define FIXEDSHARES_H
+
+/*
+* Gadgets are generic in nshares, but every call in a given build has nshares <= NSHARES.
+* The gadgets are therefore also generated for each fixed number of shares 2..8 up to NSHARES:
+* their share loops have compile-time bounds and are unrolled, and they use no VLAs.
+* IF_FIXED_n(x) expands to x only if the n-share specialization is built.
+* Build with GENERIC_GADGETS to use only the generic versions.
+*/
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 2
+    #define IF_FIXED_2(...) __VA_ARGS__
+#else
+    #define IF_FIXED_2(...)
+#endif
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 3
+    #define IF_FIXED_3(...) __VA_ARGS__
+#else
+    #define IF_FIXED_3(...)
+#endif
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 4
+    #define IF_FIXED_4(...) __VA_ARGS__
+#else
+    #define IF_FIXED_4(...)
+#endif
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 5
+    #define IF_FIXED_5(...) __VA_ARGS__
+#else
+    #define IF_FIXED_5(...)
+#endif
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 6
+    #define IF_FIXED_6(...) __VA_ARGS__
+#else
+    #define IF_FIXED_6(...)
+#endif
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 7
+    #define IF_FIXED_7(...) __VA_ARGS__
+#else
+    #define IF_FIXED_7(...)
+#endif
+
+#if !defined(GENERIC_GADGETS) && defined(NSHARES) && NSHARES >= 8
+    #define IF_FIXED_8(...) __VA_ARGS__
+#else
+    #define IF_FIXED_8(...)
+#endif
+
+// instantiate gen(n) for every specialization that is built
+#define FIXED_INSTANTIATE(gen) \
+    IF_FIXED_2(gen(2))         \
+    IF_FIXED_3(gen(3))         \
+    IF_FIXED_4(gen(4))         \
+    IF_FIXED_5(gen(5))         \
+    IF_FIXED_6(gen(6))         \
+    IF_FIXED_7(gen(7))         \
+    IF_FIXED_8(gen(8))
+
+// call f_n args and return, if a specialization for nshares is built
+#define FIXED_DISPATCH(nshares, f, args)                   \
+    switch (nshares)                                       \
+    {                                                      \
+        IF_FIXED_2(case 2: f##_2 args; return;)            \
+        IF_FIXED_3(case 3: f##_3 args; return;)            \
+        IF_FIXED_4(case 4: f##_4 args; return;)            \
+        IF_FIXED_5(case 5: f##_5 args; return;)            \
+        IF_FIXED_6(case 6: f##_6 args; return;)            \
+        IF_FIXED_7(case 7: f##_7 args; return;)            \
+        IF_FIXED_8(case 8: f##_8 args; return;)            \
+        default: break;                                    \
+    }
+
+// fully unroll a share loop
+#define FIXED_UNROLL _Pragma("GCC unroll 64")
+
+#endif // FIXEDSHARES_H
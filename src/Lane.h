@@ -0,0 +1,157 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LANE_H
+#define LANE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "randombytes.h"
+
+/*
+* lane_t is the word of the bitsliced pipeline (A2B_bitsliced, A2B_keepbitsliced, SecAdd_bitsliced, BooleanEqualityTest_Simple,
+* ReduceComparisons_GF): bit i of a bit plane belongs to coefficient i, so every gadget call handles LANE_BITS coefficients.
+*   LANE_BITS = 32, 64        : uint32_t, uint64_t, with the SecAND32/SecAND64 and RefreshXOR32/RefreshXOR gadgets
+*   LANE_BITS = 128, 256, 512 : a GCC vector of uint64_t (host only), SSE2, AVX2 or AVX-512 with the matching -m flags,
+*                               SecAND<LANE_BITS> and RefreshXOR<LANE_BITS> are instantiated from the same code
+* The gadgets of the selected lane are reached through the *L names. A lane is LANE_WORDS 32-bit words,
+* word w holds coefficients 32w .. 32w + 31. Lanes are passed by pointer, vectors by value change the ABI.
+*/
+#ifndef LANE_BITS
+    #define LANE_BITS 32
+#endif
+
+#define LANE_WORDS (LANE_BITS / 32)
+#define LANE_BATCHES(n) (((n) + LANE_BITS - 1) / LANE_BITS) // batches for n coefficients
+
+// paste after expanding the arguments, and call m with its arguments expanded (to instantiate width-pasting macros)
+#define LANE_NAME_(a, b, c) a##b##c
+#define LANE_NAME(a, b, c) LANE_NAME_(a, b, c)
+#define LANE_APPLY(m, ...) m(__VA_ARGS__)
+
+#define SecANDL LANE_NAME(SecAND, LANE_BITS, )
+#define SecANDL_batch LANE_NAME(SecAND, LANE_BITS, _batch)
+#define SecANDL_rand_words LANE_NAME(SecAND, LANE_BITS, _rand_words)
+
+#if LANE_BITS == 32
+
+    typedef uint32_t lane_t;
+
+    #define RefreshXORL RefreshXOR32
+    #define RefreshXORL_rand_words RefreshXOR32_rand_words
+    #define random_lane_n(out, len) random_uint32_n(out, len)
+
+#elif LANE_BITS == 64
+
+    typedef uint64_t lane_t;
+
+    #define RefreshXORL RefreshXOR
+    #define RefreshXORL_rand_words RefreshXOR_rand_words
+    #define random_lane_n(out, len) random_uint64_n(out, len)
+
+#elif LANE_BITS == 128 || LANE_BITS == 256 || LANE_BITS == 512
+
+    #define LANE_VECTOR
+
+    typedef uint64_t lane_t __attribute__((vector_size(LANE_BITS / 8)));
+    typedef lane_t LANE_NAME(uint, LANE_BITS, _t);
+
+    #define RefreshXORL LANE_NAME(RefreshXOR, LANE_BITS, )
+    #define RefreshXORL_rand_words LANE_NAME(RefreshXOR, LANE_BITS, _rand_words)
+    #define random_lane_n LANE_NAME(random_uint, LANE_BITS, _n)
+
+    // the names the width-pasting gadget macros expect
+    #define RNG_GADGET_SECAND128 RNG_GADGET_SECAND_LANE
+    #define RNG_GADGET_SECAND256 RNG_GADGET_SECAND_LANE
+    #define RNG_GADGET_SECAND512 RNG_GADGET_SECAND_LANE
+
+#else
+    #error "LANE_BITS must be 32, 64, 128, 256 or 512"
+#endif
+
+static inline uint32_t lane_word(const lane_t *x, size_t w)
+{
+#if LANE_BITS == 32
+    (void)w;
+    return *x;
+#elif LANE_BITS == 64
+    return (uint32_t)(*x >> (32 * w));
+#else
+    return (uint32_t)((*x)[w / 2] >> (32 * (w % 2)));
+#endif
+}
+
+static inline void lane_from_words(lane_t *x, const uint32_t w[LANE_WORDS])
+{
+#if LANE_BITS == 32
+    *x = w[0];
+#elif LANE_BITS == 64
+    *x = ((uint64_t)w[0]) | ((uint64_t)w[1]) << 32;
+#else
+    for (size_t e = 0; e < LANE_BITS / 64; e++)
+    {
+        (*x)[e] = ((uint64_t)w[2 * e]) | ((uint64_t)w[2 * e + 1]) << 32;
+    }
+#endif
+}
+
+// bit i of a lane, the bit of coefficient i
+static inline uint32_t lane_bit(const lane_t *x, size_t i)
+{
+    return (lane_word(x, i / 32) >> (i % 32)) & 1;
+}
+
+#ifdef LANE_VECTOR
+
+    // len random lanes in bulk requests, in the word order of len * LANE_WORDS single draws
+    static inline void random_lane_n(lane_t *out, size_t len)
+    {
+        uint32_t buf[64];
+
+        while (len > 0)
+        {
+            size_t n = (len < 64 / LANE_WORDS) ? len : 64 / LANE_WORDS;
+
+            random_uint32_n(buf, n * LANE_WORDS);
+            for (size_t i = 0; i < n; i++)
+            {
+                lane_from_words(&out[i], &buf[i * LANE_WORDS]);
+            }
+
+            out += n;
+            len -= n;
+        }
+    }
+
+    // a statement expression, so no vector is returned by value
+    #define random_lane() __extension__({ lane_t r_; random_lane_n(&r_, 1); r_; })
+    #define random_uint128() random_lane()
+    #define random_uint256() random_lane()
+    #define random_uint512() random_lane()
+
+#endif
+
+#endif // LANE_H
@@ -32,6 +32,7 @@
 #include "A2B.h"
 #include "B2A.h"
 #include "SecAnd.h"
+#include "SecAdd.h"
 #include "SecMult.h"
 #include "hal.h"
 #include <string.h>
@@ -82,6 +83,163 @@ static void shared_compress(size_t ncoeffs, size_t compressto, uint32_t B[ncoeff
 }
 #endif
 
+#ifdef KYBER_MODQ_A2B
+// smallest x (possibly negative) that compresses to c: ceil((c Q - Q/2) / 2^compressto), on public values
+static int32_t interval_lo(uint32_t c, size_t compressto)
+{
+    int32_t num = (int32_t)(c * Q) - Q/2;
+
+    return (num >= 0) ? (num + (1 << compressto) - 1) >> compressto : -((-num) >> compressto);
+}
+
+/*
+* x compresses to the public c iff (x - lo(c)) mod Q < lo(c + 1) - lo(c). Subtracts lo(c) mod Q from share 0, keeping
+* the shares in [0, Q), and returns the widths: A2B_keepbitsliced_modq then only checks the masked range.
+*/
+static void shared_interval(size_t ncoeffs, size_t compressto, uint32_t B[ncoeffs][NSHARES], uint32_t width[ncoeffs], const uint32_t public[ncoeffs])
+{
+    for (size_t i = 0; i < ncoeffs; i++)
+    {
+        int32_t lo = interval_lo(public[i], compressto);
+        uint32_t lo_q = (lo < 0) ? (uint32_t)(lo + Q) : (uint32_t)lo;
+
+        width[i] = interval_lo(public[i] + 1, compressto) - lo;
+
+    #ifdef DEBUG
+
+        uint32_t B_unmasked = 0;
+
+        for (size_t j = 0; j < NSHARES; j++)
+        {
+            B_unmasked = (B_unmasked + B[i][j]) % Q;
+        }
+
+        uint32_t B_compressed = (((B_unmasked << compressto) + Q/2) / Q) & bit_mask(compressto);
+
+        assert((B_compressed == public[i]) == ((B_unmasked + Q - lo_q) % Q < width[i]));
+
+    #endif
+
+        // share 0 is secret: subtract without a data-dependent branch
+        uint32_t t = B[i][0] - lo_q;
+
+        B[i][0] = t + (Q & -(t >> 31));
+    }
+}
+#endif
+
+#ifdef PUBLIC_AFTER_A2B
+// subtract the public values from the kept (top compressto) bits after A2B, as a bitsliced public constant addition
+static void public_sub_bitsliced(size_t ncoeffs, size_t compressto, lane_t out[][NSHARES], const uint32_t public[ncoeffs])
+{
+    uint32_t words[compressto][LANE_WORDS];
+    lane_t c[compressto];
+
+    for (size_t i = 0; i < ncoeffs; i += LANE_BITS)
+    {
+        for (size_t k = 0; k < compressto; k++)
+        {
+            for (size_t w = 0; w < LANE_WORDS; w++)
+            {
+                words[k][w] = 0;
+            }
+        }
+
+        for (size_t l = 0; l < LANE_BITS && i + l < ncoeffs; l++)
+        {
+            uint32_t negpublic = -public[i + l];
+
+            for (size_t k = 0; k < compressto; k++)
+            {
+                words[k][l / 32] |= ((negpublic >> k) & 1) << (l % 32);
+            }
+        }
+
+        for (size_t k = 0; k < compressto; k++)
+        {
+            lane_from_words(&c[k], words[k]);
+        }
+
+        SecConstAdd_bitsliced(NSHARES, compressto, &out[i / LANE_BITS * compressto], &out[i / LANE_BITS * compressto], c);
+    }
+}
+#endif
+
+#ifdef ARITH_STREAMING
+/*
+* Arith on ncoeffs coefficients, one batch of LANE_BITS at a time: preprocessing, A2B, compression, B2A and the
+* random linear combination of ReduceComparisons_update, so only one batch is held in every representation.
+*/
+static void stream_arith(uint64_t E[NSHARES], size_t ncoeffs, uint32_t compressfrom, uint32_t compressto, enum adder_topology adder,
+                         const uint32_t A[ncoeffs][NSHARES], const uint32_t public[ncoeffs], lane_t workspace[], uint64_t b2a_workspace[])
+{
+    uint32_t Ap[LANE_BITS][NSHARES], A_compressed[LANE_BITS][NSHARES];
+    uint64_t A_reshared[LANE_BITS][NSHARES];
+
+    for (size_t i = 0; i < ncoeffs; i += LANE_BITS)
+    {
+        size_t count = (ncoeffs - i < LANE_BITS) ? ncoeffs - i : LANE_BITS;
+
+        memcpy(Ap, &A[i], count * NSHARES * sizeof(uint32_t));
+
+        #if defined(KYBER)
+            shared_compress(count, compressto, Ap);
+        #endif
+
+        for (size_t l = 0; l < count; l++)
+        {
+            Ap[l][0] = (Ap[l][0] - (public[i + l] << (compressfrom - compressto))) & bit_mask(compressfrom);
+        }
+
+        A2B_bitsliced(NSHARES, count, compressfrom, adder, A_compressed, Ap, workspace);
+
+        for (size_t l = 0; l < count; l++)
+        {
+            for (size_t j = 0; j < NSHARES; j++)
+            {
+                A_compressed[l][j] = (A_compressed[l][j] >> (compressfrom - compressto)) & bit_mask(compressto);
+            }
+        }
+
+        B2A_batch(count, A_reshared, A_compressed, b2a_workspace);
+        ReduceComparisons_update(E, count, A_reshared);
+    }
+}
+
+uint64_t MaskedComparison_Arith(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_t C[NCOEFFS_C][NSHARES],
+                          const uint32_t public_B[NCOEFFS_B], const uint32_t public_C[NCOEFFS_C])
+{
+    uint64_t E[NSHARES];
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS)];
+    uint64_t b2a_workspace[B2A_batch_workspace_size()];
+
+    PROFILE_STEP_INIT();
+
+    ////////////////////////////////////////////////////////////
+    ///   Step 0 to 3 : Preprocessing to ReduceComparisons   ///
+    ////////////////////////////////////////////////////////////
+
+    PROFILE_STEP_START();
+
+    ReduceComparisons_init(E);
+    stream_arith(E, NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, ADDER_B, B, public_B, workspace, b2a_workspace);
+    stream_arith(E, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, ADDER_C, C, public_C, workspace, b2a_workspace);
+
+    PROFILE_STEP_STOP(3);
+
+    ////////////////////////////////////////////////////////////
+    ///            Step 4 : BooleanEqualityTest              ///
+    ////////////////////////////////////////////////////////////
+
+    PROFILE_STEP_START();
+
+    uint64_t result = BooleanEqualityTest(E);
+
+    PROFILE_STEP_STOP(4);
+
+    return result;
+}
+#else
 uint64_t MaskedComparison_Arith(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_t C[NCOEFFS_C][NSHARES],
                           const uint32_t public_B[NCOEFFS_B], const uint32_t public_C[NCOEFFS_C])
 {
@@ -125,10 +283,9 @@ uint64_t MaskedComparison_Arith(const uint32_t B[NCOEFFS_B][NSHARES], const uint
 
     PROFILE_STEP_START();
 
-    for (size_t i = 0; i < NCOEFFS_B; i += 32)
-    {
-        A2B_bitsliced(NSHARES, COMPRESSFROM_B, B_compressed + i, Bp + i);
-    }
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS)];
+
+    A2B_bitsliced(NSHARES, NCOEFFS_B, COMPRESSFROM_B, ADDER_B, B_compressed, Bp, workspace);
 
     for (size_t i = 0; i < NCOEFFS_B; i++)
     {
@@ -138,10 +295,7 @@ uint64_t MaskedComparison_Arith(const uint32_t B[NCOEFFS_B][NSHARES], const uint
         }
     }
 
-    for (size_t i = 0; i < NCOEFFS_C; i += 32)
-    {
-        A2B_bitsliced(NSHARES, COMPRESSFROM_C, C_compressed + i, Cp + i);
-    }
+    A2B_bitsliced(NSHARES, NCOEFFS_C, COMPRESSFROM_C, ADDER_C, C_compressed, Cp, workspace);
 
     for (size_t i = 0; i < NCOEFFS_C; i++)
     {
@@ -157,17 +311,12 @@ uint64_t MaskedComparison_Arith(const uint32_t B[NCOEFFS_B][NSHARES], const uint
     ///                    Step 2 : B2A                      ///
     ////////////////////////////////////////////////////////////
 
-    PROFILE_STEP_START();
+    uint64_t b2a_workspace[B2A_batch_workspace_size()];
 
-    for (size_t i = 0; i < NCOEFFS_B; i++)
-    {
-        B2A(BC_reshared[i], B_compressed[i]);
-    }
+    PROFILE_STEP_START();
 
-    for (size_t i = 0; i < NCOEFFS_C; i++)
-    {
-        B2A(BC_reshared[NCOEFFS_B + i], C_compressed[i]);
-    }
+    B2A_batch(NCOEFFS_B, BC_reshared, B_compressed, b2a_workspace);
+    B2A_batch(NCOEFFS_C, BC_reshared + NCOEFFS_B, C_compressed, b2a_workspace);
 
     PROFILE_STEP_STOP(2);
 
@@ -193,6 +342,7 @@ uint64_t MaskedComparison_Arith(const uint32_t B[NCOEFFS_B][NSHARES], const uint
 
     return result;
 }
+#endif
 
 uint64_t MaskedComparison_Simple(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_t C[NCOEFFS_C][NSHARES],
                           const uint32_t public_B[NCOEFFS_B], const uint32_t public_C[NCOEFFS_C])
@@ -210,20 +360,27 @@ uint64_t MaskedComparison_Simple(const uint32_t B[NCOEFFS_B][NSHARES], const uin
     memcpy(Bp, B, NCOEFFS_B * NSHARES * sizeof(uint32_t));
     memcpy(Cp, C, NCOEFFS_C * NSHARES * sizeof(uint32_t));
 
-    #if defined(KYBER)
+    #if defined(KYBER_MODQ_A2B)
+        uint32_t width_B[NCOEFFS_B], width_C[NCOEFFS_C];
+
+        shared_interval(NCOEFFS_B, COMPRESSTO_B, Bp, width_B, public_B);
+        shared_interval(NCOEFFS_C, COMPRESSTO_C, Cp, width_C, public_C);
+    #elif defined(KYBER)
         shared_compress(NCOEFFS_B, COMPRESSTO_B, Bp);
         shared_compress(NCOEFFS_C, COMPRESSTO_C, Cp);
     #endif
 
-    for (size_t i = 0; i < NCOEFFS_B; i++)
-    {
-        Bp[i][0] = (Bp[i][0] - (public_B[i] << (COMPRESSFROM_B - COMPRESSTO_B))) & bit_mask(COMPRESSFROM_B);
-    }
+    #if !defined(PUBLIC_AFTER_A2B) && !defined(KYBER_MODQ_A2B)
+        for (size_t i = 0; i < NCOEFFS_B; i++)
+        {
+            Bp[i][0] = (Bp[i][0] - (public_B[i] << (COMPRESSFROM_B - COMPRESSTO_B))) & bit_mask(COMPRESSFROM_B);
+        }
 
-    for (size_t i = 0; i < NCOEFFS_C; i++)
-    {
-        Cp[i][0] = (Cp[i][0] - (public_C[i] << (COMPRESSFROM_C - COMPRESSTO_C))) & bit_mask(COMPRESSFROM_C);
-    }
+        for (size_t i = 0; i < NCOEFFS_C; i++)
+        {
+            Cp[i][0] = (Cp[i][0] - (public_C[i] << (COMPRESSFROM_C - COMPRESSTO_C))) & bit_mask(COMPRESSFROM_C);
+        }
+    #endif
 
     PROFILE_STEP_STOP(0);
 
@@ -231,11 +388,21 @@ uint64_t MaskedComparison_Simple(const uint32_t B[NCOEFFS_B][NSHARES], const uin
     ///                    Step 1 : A2B                      ///
     ////////////////////////////////////////////////////////////
 
-    uint32_t BC_Bitsliced[ SIMPLECOMPBITS ][NSHARES];
+    lane_t BC_Bitsliced[ SIMPLECOMPBITS ][NSHARES];
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS_KEEP)];
 
     PROFILE_STEP_START();
 
-    A2B_keepbitsliced(NSHARES, NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, BC_Bitsliced, Bp, Cp);
+    #ifdef KYBER_MODQ_A2B
+        A2B_keepbitsliced_modq(NSHARES, NCOEFFS_B, NCOEFFS_C, ADDER_B, BC_Bitsliced, Bp, Cp, width_B, width_C, workspace);
+    #else
+        A2B_keepbitsliced(NSHARES, NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, ADDER_B, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, ADDER_C, BC_Bitsliced, Bp, Cp, workspace);
+    #endif
+
+    #ifdef PUBLIC_AFTER_A2B
+        public_sub_bitsliced(NCOEFFS_B, COMPRESSTO_B, BC_Bitsliced, public_B);
+        public_sub_bitsliced(NCOEFFS_C, COMPRESSTO_C, &BC_Bitsliced[LANE_BATCHES(NCOEFFS_B) * COMPRESSTO_B], public_C);
+    #endif
 
     PROFILE_STEP_STOP(1);
 
@@ -364,13 +531,11 @@ uint64_t MaskedComparison_Simple_NBSO(const uint32_t B[NCOEFFS_B][NSHARES], cons
     ////////////////////////////////////////////////////////////
 
     uint32_t BC[NCOEFFS_B + NCOEFFS_C][NSHARES];
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS)];
 
     PROFILE_STEP_START();
 
-    for (size_t i = 0; i < NCOEFFS_B; i += 32)
-    {
-        A2B_bitsliced(NSHARES, COMPRESSFROM_B, BC + i, Bp + i);
-    }
+    A2B_bitsliced(NSHARES, NCOEFFS_B, COMPRESSFROM_B, ADDER_B, BC, Bp, workspace);
 
     for (size_t i = 0; i < NCOEFFS_B; i++)
     {
@@ -380,10 +545,7 @@ uint64_t MaskedComparison_Simple_NBSO(const uint32_t B[NCOEFFS_B][NSHARES], cons
         }
     }
 
-    for (size_t i = 0; i < NCOEFFS_C; i += 32)
-    {
-        A2B_bitsliced(NSHARES, COMPRESSFROM_C, BC + (NCOEFFS_B + i), Cp + i);
-    }
+    A2B_bitsliced(NSHARES, NCOEFFS_C, COMPRESSFROM_C, ADDER_C, BC + NCOEFFS_B, Cp, workspace);
 
     for (size_t i = 0; i < NCOEFFS_C; i++)
     {
@@ -402,17 +564,58 @@ uint64_t MaskedComparison_Simple_NBSO(const uint32_t B[NCOEFFS_B][NSHARES], cons
 
     PROFILE_STEP_START();
 
-    uint64_t result = BooleanEqualityTest_Simple(BC, NCOEFFS_B + NCOEFFS_C);
+    uint64_t result = BooleanEqualityTest_Simple32(BC, NCOEFFS_B + NCOEFFS_C);
 
     PROFILE_STEP_STOP(4);
 
     return result;
 }
 
+#ifdef GF_STREAMING
+/*
+* A2B and GF reduction of ncoeffs coefficients, one batch of LANE_BITS at a time: the kept planes of a batch are reduced
+* right after its A2B and then overwritten by the next batch. KYBER_MODQ_A2B keeps compressto = 1 plane per batch
+* and needs the widths of shared_interval, the other methods pass NULL. The A2B schedule is built once for all batches.
+*/
+static void stream_A2B_reduce(struct gf_reduce_state *state, size_t ncoeffs, uint32_t compressfrom, uint32_t compressto, enum adder_topology adder,
+                              const uint32_t A[ncoeffs][NSHARES], const uint32_t public[ncoeffs], const uint32_t width[], lane_t workspace[])
+{
+    lane_t rows[compressto][NSHARES];
+    struct a2b_step steps[NSHARES];
+
+    A2B_schedule(NSHARES, steps);
+
+    for (size_t i = 0; i < ncoeffs; i += LANE_BITS)
+    {
+        size_t count = (ncoeffs - i < LANE_BITS) ? ncoeffs - i : LANE_BITS;
+
+        #ifdef KYBER_MODQ_A2B
+            (void)compressfrom;
+            (void)public;
+            A2B_keepbitsliced_modq_one_batch(NSHARES, count, adder, steps, rows[0], &A[i], &width[i], workspace);
+        #else
+            (void)width;
+            A2B_keepbitsliced_one_batch(NSHARES, count, compressfrom, compressto, adder, steps, rows, &A[i], workspace);
+            #ifdef PUBLIC_AFTER_A2B
+                public_sub_bitsliced(count, compressto, rows, &public[i]);
+            #else
+                (void)public;
+            #endif
+        #endif
+
+        ReduceComparisons_GF_absorb(state, compressto, rows);
+    }
+}
+#endif
+
 uint64_t MaskedComparison_GF(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_t C[NCOEFFS_C][NSHARES],
                           const uint32_t public_B[NCOEFFS_B], const uint32_t public_C[NCOEFFS_C])
 {
-    struct uint96_t E;
+#ifdef GF_POLYEVAL
+    uint32_t E[GF_POLYEVAL_WORDS][NSHARES];
+#else
+    uint32_t E[GF_REDUCE_WORDS][NSHARES];
+#endif
     uint32_t Bp[NCOEFFS_B][NSHARES], Cp[NCOEFFS_C][NSHARES];
 
     PROFILE_STEP_INIT();
@@ -426,32 +629,73 @@ uint64_t MaskedComparison_GF(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_
     memcpy(Bp, B, NCOEFFS_B * NSHARES * sizeof(uint32_t));
     memcpy(Cp, C, NCOEFFS_C * NSHARES * sizeof(uint32_t));
 
-    #if defined(KYBER)
+    #if defined(KYBER_MODQ_A2B)
+        uint32_t width_B[NCOEFFS_B], width_C[NCOEFFS_C];
+
+        shared_interval(NCOEFFS_B, COMPRESSTO_B, Bp, width_B, public_B);
+        shared_interval(NCOEFFS_C, COMPRESSTO_C, Cp, width_C, public_C);
+    #elif defined(KYBER)
         shared_compress(NCOEFFS_B, COMPRESSTO_B, Bp);
         shared_compress(NCOEFFS_C, COMPRESSTO_C, Cp);
     #endif
 
-    for (size_t i = 0; i < NCOEFFS_B; i++)
-    {
-        Bp[i][0] = (Bp[i][0] - (public_B[i] << (COMPRESSFROM_B - COMPRESSTO_B))) & bit_mask(COMPRESSFROM_B);
-    }
+    #if !defined(PUBLIC_AFTER_A2B) && !defined(KYBER_MODQ_A2B)
+        for (size_t i = 0; i < NCOEFFS_B; i++)
+        {
+            Bp[i][0] = (Bp[i][0] - (public_B[i] << (COMPRESSFROM_B - COMPRESSTO_B))) & bit_mask(COMPRESSFROM_B);
+        }
 
-    for (size_t i = 0; i < NCOEFFS_C; i++)
-    {
-        Cp[i][0] = (Cp[i][0] - (public_C[i] << (COMPRESSFROM_C - COMPRESSTO_C))) & bit_mask(COMPRESSFROM_C);
-    }
+        for (size_t i = 0; i < NCOEFFS_C; i++)
+        {
+            Cp[i][0] = (Cp[i][0] - (public_C[i] << (COMPRESSFROM_C - COMPRESSTO_C))) & bit_mask(COMPRESSFROM_C);
+        }
+    #endif
 
     PROFILE_STEP_STOP(0);
 
+#ifdef GF_STREAMING
+    ////////////////////////////////////////////////////////////
+    ///        Step 1 + 3 : A2B and ReduceComparisons        ///
+    ////////////////////////////////////////////////////////////
+
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS_KEEP)];
+    struct gf_reduce_state state;
+
+    PROFILE_STEP_START();
+
+    ReduceComparisons_GF_init(&state, GF_REDUCE_WORDS);
+
+    #ifdef KYBER_MODQ_A2B
+        stream_A2B_reduce(&state, NCOEFFS_B, MODQ_BITS, 1, ADDER_B, Bp, public_B, width_B, workspace);
+        stream_A2B_reduce(&state, NCOEFFS_C, MODQ_BITS, 1, ADDER_B, Cp, public_C, width_C, workspace);
+    #else
+        stream_A2B_reduce(&state, NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, ADDER_B, Bp, public_B, NULL, workspace);
+        stream_A2B_reduce(&state, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, ADDER_C, Cp, public_C, NULL, workspace);
+    #endif
+
+    ReduceComparisons_GF_finish(&state, E);
+
+    PROFILE_STEP_STOP(1);
+#else
     ////////////////////////////////////////////////////////////
     ///                    Step 1 : A2B                      ///
     ////////////////////////////////////////////////////////////
 
-    uint32_t BC_Bitsliced[ SIMPLECOMPBITS ][NSHARES];
+    lane_t BC_Bitsliced[ SIMPLECOMPBITS ][NSHARES];
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS_KEEP)];
 
     PROFILE_STEP_START();
 
-    A2B_keepbitsliced(NSHARES, NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, BC_Bitsliced, Bp, Cp);
+    #ifdef KYBER_MODQ_A2B
+        A2B_keepbitsliced_modq(NSHARES, NCOEFFS_B, NCOEFFS_C, ADDER_B, BC_Bitsliced, Bp, Cp, width_B, width_C, workspace);
+    #else
+        A2B_keepbitsliced(NSHARES, NCOEFFS_B, COMPRESSFROM_B, COMPRESSTO_B, ADDER_B, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, ADDER_C, BC_Bitsliced, Bp, Cp, workspace);
+    #endif
+
+    #ifdef PUBLIC_AFTER_A2B
+        public_sub_bitsliced(NCOEFFS_B, COMPRESSTO_B, BC_Bitsliced, public_B);
+        public_sub_bitsliced(NCOEFFS_C, COMPRESSTO_C, &BC_Bitsliced[LANE_BATCHES(NCOEFFS_B) * COMPRESSTO_B], public_C);
+    #endif
 
     PROFILE_STEP_STOP(1);
 
@@ -461,9 +705,14 @@ uint64_t MaskedComparison_GF(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_
 
     PROFILE_STEP_START();
 
-    ReduceComparisons_GF(&E, BC_Bitsliced);
+    #ifdef GF_POLYEVAL
+        ReduceComparisons_GF_polyeval(E, BC_Bitsliced);
+    #else
+        ReduceComparisons_GF(GF_REDUCE_WORDS, E, BC_Bitsliced);
+    #endif
 
     PROFILE_STEP_STOP(3);
+#endif
 
     ////////////////////////////////////////////////////////////
     ///            Step 4 : BooleanEqualityTest              ///
@@ -471,13 +720,72 @@ uint64_t MaskedComparison_GF(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_
 
     PROFILE_STEP_START();
 
-    uint64_t result = BooleanEqualityTest_GF(E);
+    #ifdef GF_POLYEVAL
+        uint64_t result = BooleanEqualityTest_Simple32(E, GF_POLYEVAL_WORDS);
+    #else
+        uint64_t result = BooleanEqualityTest_Simple32(E, GF_REDUCE_WORDS);
+    #endif
 
     PROFILE_STEP_STOP(4);
 
     return result;
 }
 
+// A2B_keepbitsliced words of Simple and GF
+static size_t keepbitsliced_rand_words(void)
+{
+    #ifdef KYBER_MODQ_A2B
+        return A2B_keepbitsliced_modq_rand_words(NSHARES, NCOEFFS_B, NCOEFFS_C, ADDER_B);
+    #else
+        return A2B_keepbitsliced_rand_words(NSHARES, NCOEFFS_B, COMPRESSFROM_B, ADDER_B, NCOEFFS_C, COMPRESSFROM_C, ADDER_C);
+    #endif
+}
+
+// SecConstAdd_bitsliced words for PUBLIC_AFTER_A2B, none when the public values are subtracted before A2B
+static size_t public_sub_rand_words(void)
+{
+    #ifdef PUBLIC_AFTER_A2B
+        return LANE_BATCHES(NCOEFFS_B) * SecConstAdd_bitsliced_rand_words(NSHARES, COMPRESSTO_B) + LANE_BATCHES(NCOEFFS_C) * SecConstAdd_bitsliced_rand_words(NSHARES, COMPRESSTO_C);
+    #else
+        return 0;
+    #endif
+}
+
+// number of 32-bit random words drawn per call, for replaying a pre-filled RNG_TAPE
+size_t MaskedComparison_Arith_rand_words()
+{
+    return LANE_BATCHES(NCOEFFS_B) * A2B_bitsliced_rand_words(NSHARES, COMPRESSFROM_B, ADDER_B) + LANE_BATCHES(NCOEFFS_C) * A2B_bitsliced_rand_words(NSHARES, COMPRESSFROM_C, ADDER_C) +
+           (NCOEFFS_B + NCOEFFS_C) * B2A_rand_words() + ReduceComparisons_rand_words() + BooleanEqualityTest_rand_words();
+}
+
+size_t MaskedComparison_Simple_rand_words()
+{
+    return keepbitsliced_rand_words() + BooleanEqualityTest_Simple_rand_words(SIMPLECOMPBITS) +
+           public_sub_rand_words();
+}
+
+size_t MaskedComparison_Simple_NBS_rand_words()
+{
+    return (NCOEFFS_B + NCOEFFS_C) * A2B32_rand_words(NSHARES) + BooleanEqualityTest_Simple_NBS_rand_words();
+}
+
+size_t MaskedComparison_Simple_NBSO_rand_words()
+{
+    return LANE_BATCHES(NCOEFFS_B) * A2B_bitsliced_rand_words(NSHARES, COMPRESSFROM_B, ADDER_B) + LANE_BATCHES(NCOEFFS_C) * A2B_bitsliced_rand_words(NSHARES, COMPRESSFROM_C, ADDER_C) +
+           BooleanEqualityTest_Simple32_rand_words(NCOEFFS_B + NCOEFFS_C);
+}
+
+size_t MaskedComparison_GF_rand_words()
+{
+    #ifdef GF_POLYEVAL
+        return keepbitsliced_rand_words() + ReduceComparisons_GF_polyeval_rand_words() + BooleanEqualityTest_Simple32_rand_words(GF_POLYEVAL_WORDS) +
+               public_sub_rand_words();
+    #else
+        return keepbitsliced_rand_words() + ReduceComparisons_GF_rand_words(GF_REDUCE_WORDS) +
+               BooleanEqualityTest_Simple32_rand_words(GF_REDUCE_WORDS) + public_sub_rand_words();
+    #endif
+}
+
 #ifdef KYBER
 uint64_t MaskedComparison_HybridSimple(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_t C[NCOEFFS_C][NSHARES],
                           const uint32_t public_B[NCOEFFS_B], const uint32_t public_C[NCOEFFS_C])
@@ -513,8 +821,16 @@ uint64_t MaskedComparison_HybridSimple(const uint32_t B[NCOEFFS_B][NSHARES], con
     uint32_t E[32][NSHARES];
     memset(E, 0, 32 * NSHARES * sizeof(uint32_t));
 
+    // compression randomness, sampled in bulk for a block of 32 coefficients
+    uint32_t R[32 * LB];
+
     for (int i = 0; i < NCOEFFS_B; i++)
     {
+        if (i % 32 == 0)
+        {
+            randomq_batch(32 * LB, R, Q);
+        }
+
         // decompress
         uint32_t uncL, uncH;
         uncL = uncompress(public_B[i], COMPRESSTO_B, Q);
@@ -543,14 +859,11 @@ uint64_t MaskedComparison_HybridSimple(const uint32_t B[NCOEFFS_B][NSHARES], con
         memcpy(Bp[i], p_in, NSHARES * sizeof(uint32_t));
 
         // compression
-        uint32_t R[2];
-        for (int j = 0; j < LB; j+=2)
+        for (int j = 0; j < LB; j++)
         {
-            randomq(R, Q);
             for (int k = 0; k < NSHARES; k++)
             {
-                E[j][k] += R[0] * Bp[i][k];
-                E[j + 1][k] += R[1] * Bp[i][k];
+                E[j][k] += R[(i % 32) * LB + j] * Bp[i][k];
             }
         }
     }
@@ -571,11 +884,12 @@ uint64_t MaskedComparison_HybridSimple(const uint32_t B[NCOEFFS_B][NSHARES], con
     ///                    Step 2 : A2B                      ///
     ////////////////////////////////////////////////////////////
 
-    uint32_t BC_Bitsliced[ SIMPLECOMPBITS_HYBRID ][NSHARES];
+    lane_t BC_Bitsliced[ SIMPLECOMPBITS_HYBRID ][NSHARES];
+    lane_t workspace[A2B_bitsliced_workspace_size(NSHARES, A2B_NBITS_HYBRID)];
     
     PROFILE_STEP_START();
 
-    A2B_keepbitsliced(NSHARES, 32, COMPRESSFROM_B_HYBRID, COMPRESSTO_B_HYBRID, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, BC_Bitsliced, E, Cp);
+    A2B_keepbitsliced(NSHARES, 32, COMPRESSFROM_B_HYBRID, COMPRESSTO_B_HYBRID, ADDER_B_HYBRID, NCOEFFS_C, COMPRESSFROM_C, COMPRESSTO_C, ADDER_C, BC_Bitsliced, E, Cp, workspace);
 
     PROFILE_STEP_STOP(2);
 
@@ -55,4 +55,10 @@ uint64_t MaskedComparison_GF(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_
 uint64_t MaskedComparison_HybridSimple(const uint32_t B[NCOEFFS_B][NSHARES], const uint32_t C[NCOEFFS_C][NSHARES],
                           const uint32_t public_B[NCOEFFS_B], const uint32_t public_C[NCOEFFS_C]);
 
+size_t MaskedComparison_Arith_rand_words(void);
+size_t MaskedComparison_Simple_rand_words(void);
+size_t MaskedComparison_Simple_NBS_rand_words(void);
+size_t MaskedComparison_Simple_NBSO_rand_words(void);
+size_t MaskedComparison_GF_rand_words(void);
+
 #endif // MASKEDCOMPARISON_H
\ No newline at end of file
@@ -27,15 +27,27 @@
 #include "ReduceComparisons.h"
 #include "randombytes.h"
 #include "params.h"
+#include "Clmul.h"
 
 void ReduceComparisons(uint64_t E[NSHARES], const uint64_t D[NCOEFFS_B + NCOEFFS_C][NSHARES])
+{
+    ReduceComparisons_init(E);
+    ReduceComparisons_update(E, NCOEFFS_B + NCOEFFS_C, D);
+}
+
+void ReduceComparisons_init(uint64_t E[NSHARES])
 {
     for (size_t j = 0; j < NSHARES; j++)
     {
         E[j] = 0;
     }
+}
 
-    for (size_t i = 0; i < (NCOEFFS_B + NCOEFFS_C); i++)
+void ReduceComparisons_update(uint64_t E[NSHARES], size_t count, const uint64_t D[count][NSHARES])
+{
+    PROFILE_RAND_GADGET(RNG_GADGET_REDUCECOMPARISONS);
+
+    for (size_t i = 0; i < count; i++)
     {
         uint64_t R = random_uint64();
 
@@ -52,35 +64,265 @@ void ReduceComparisons(uint64_t E[NSHARES], const uint64_t D[NCOEFFS_B + NCOEFFS
 #endif
         }
     }
+
+    PROFILE_RAND_GADGET_END();
 }
 
-void ReduceComparisons_GF(struct uint96_t *E, uint32_t BC_Bitsliced[SIMPLECOMPBITS][NSHARES])
+// x^bits + the terms below, irreducible over GF(2), for bits = 32, 64, 96 and 128
+static const size_t gf_poly[4][4] = {{7, 3, 2, 0}, {4, 3, 1, 0}, {10, 9, 6, 0}, {7, 2, 1, 0}};
+
+// out = v >> s on 256 bits, public s
+static void shr256(uint64_t out[4], const uint64_t v[4], size_t s)
 {
-    uint32_t biti;
-    uint64_t tmp;
+    size_t w = s / 64, b = s % 64;
 
-    for (size_t i = 0; i < NSHARES; i++)
+    for (size_t i = 0; i < 4; i++)
     {
+        uint64_t x = (i + w < 4) ? v[i + w] : 0;
+        uint64_t y = (i + w + 1 < 4) ? v[i + w + 1] : 0;
+
+        out[i] = (b == 0) ? x : (x >> b) | (y << (64 - b));
+    }
+}
+
+// v ^= x << s on 256 bits, public s < 64
+static void xor_shl256(uint64_t v[4], const uint64_t x[4], size_t s)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        v[i] ^= (s == 0) ? x[i] : (x[i] << s) | ((i > 0) ? x[i - 1] >> (64 - s) : 0);
+    }
+}
+
+/*
+* v mod the field polynomial of GF(2^bits): the bits of degree bits and up are folded back onto the terms of gf_poly, which lowers
+* the degree d to d - bits + 10. Two folds reduce any product of two field elements.
+*/
+static void gf_reduce(uint64_t v[4], size_t bits)
+{
+    for (size_t fold = 0; fold < 2; fold++)
+    {
+        uint64_t H[4];
+
+        shr256(H, v, bits);
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            if (64 * i >= bits)
+            {
+                v[i] = 0;
+            }
+            else if (64 * (i + 1) > bits)
+            {
+                v[i] &= ((uint64_t)1 << (bits % 64)) - 1;
+            }
+        }
+
+        for (size_t t = 0; t < 4; t++)
+        {
+            xor_shl256(v, H, gf_poly[bits / 32 - 1][t]);
+        }
+    }
+}
+
+// v = x * y, unreduced, for elements in two 64-bit words
+static void gf_mul_unreduced(uint64_t v[4], const uint64_t x[2], const uint64_t y[2])
+{
+    const size_t nw = (GF_POLYEVAL_BITS + 63) / 64;
+    uint64_t lo, hi;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        v[i] = 0;
+    }
+
+    for (size_t i = 0; i < nw; i++)
+    {
+        for (size_t j = 0; j < nw; j++)
+        {
+            clmul64(&lo, &hi, x[i], y[j]);
+            v[i + j] ^= lo;
+            v[i + j + 1] ^= hi;
+        }
+    }
+}
+
+/*
+* every 32-bit word of a lane, the LANE_WORDS words of a row in order, is multiplied with its own random R in GF(2^bits),
+* bits = 32 * nwords: E ^= R * word. The products are summed unreduced in the state and reduced once per share at the end.
+*/
+void ReduceComparisons_GF_init(struct gf_reduce_state *state, size_t nwords)
+{
+    state->nwords = nwords;
+
+    for (size_t j = 0; j < NSHARES; j++)
+    {
+        state->lo[0][j] = state->lo[1][j] = 0;
+        state->hi[0][j] = state->hi[1][j] = 0;
+    }
+}
+
+void ReduceComparisons_GF_absorb(struct gf_reduce_state *state, size_t nrows, lane_t rows[nrows][NSHARES])
+{
+    const size_t m = nrows * LANE_WORDS, nwords = state->nwords;
+    uint32_t words[NSHARES];
+    uint32_t R[GF_REDUCE_BATCH * 4];
+
+    PROFILE_RAND_GADGET(RNG_GADGET_REDUCECOMPARISONS_GF);
+
+    for (size_t idx = 0; idx < m; idx++)
+    {
+        size_t t = idx % GF_REDUCE_BATCH;
+        const uint32_t *Rt = &R[t * nwords];
+
+        // the R's of GF_REDUCE_BATCH words are drawn at once
+        if (t == 0)
+        {
+            size_t count = (m - idx < GF_REDUCE_BATCH) ? m - idx : GF_REDUCE_BATCH;
+
+            random_uint32_n(R, count * nwords);
+        }
+
         for (size_t j = 0; j < NSHARES; j++)
         {
-            E->MSB[i] = 0;
-            E->LSB[i] = 0;
+            words[j] = lane_word(&rows[idx / LANE_WORDS][j], idx % LANE_WORDS);
+        }
+
+        clmul64x32_xor(NSHARES, state->lo[0], state->hi[0], Rt[0] | ((nwords > 1) ? ((uint64_t)Rt[1]) << 32 : 0), words);
+        if (nwords > 2)
+        {
+            clmul64x32_xor(NSHARES, state->lo[1], state->hi[1], Rt[2] | ((nwords > 3) ? ((uint64_t)Rt[3]) << 32 : 0), words);
         }
     }
 
-    for (size_t i = 0; i < SIMPLECOMPBITS; i++)
+    PROFILE_RAND_GADGET_END();
+}
+
+void ReduceComparisons_GF_finish(const struct gf_reduce_state *state, uint32_t E[][NSHARES])
+{
+    uint64_t v[4];
+
+    for (size_t j = 0; j < NSHARES; j++)
     {
-        uint64_t R = random_uint64();
+        v[0] = state->lo[0][j];
+        v[1] = state->hi[0][j] ^ state->lo[1][j];
+        v[2] = state->hi[1][j];
+        v[3] = 0;
+        gf_reduce(v, 32 * state->nwords);
+
+        for (size_t i = 0; i < state->nwords; i++)
+        {
+            E[i][j] = (uint32_t)(v[i / 2] >> (32 * (i % 2)));
+        }
+    }
+}
+
+void ReduceComparisons_GF(size_t nwords, uint32_t E[][NSHARES], lane_t BC_Bitsliced[SIMPLECOMPBITS][NSHARES])
+{
+    struct gf_reduce_state state;
+
+    ReduceComparisons_GF_init(&state, nwords);
+    ReduceComparisons_GF_absorb(&state, SIMPLECOMPBITS, BC_Bitsliced);
+    ReduceComparisons_GF_finish(&state, E);
+}
+
+/*
+* E = sum_i word_i * r^i for one random r, on every share, with word i the i-th word in the order of ReduceComparisons_GF.
+* Horner's rule runs on blocks of GF_POLYEVAL_BLOCK words: within a block each share accumulates word * r^t unreduced with
+* clmul64x32_xor and the precomputed powers r^t, as ReduceComparisons_GF does with its R's, then E = E * r^GF_POLYEVAL_BLOCK
+* + block is one field multiplication per share and block instead of one per share and word.
+*/
+void ReduceComparisons_GF_polyeval(uint32_t E[GF_POLYEVAL_WORDS][NSHARES], lane_t BC_Bitsliced[SIMPLECOMPBITS][NSHARES])
+{
+    const size_t m = (SIMPLECOMPBITS) * LANE_WORDS;
+    uint64_t r[2] = {0}, power[GF_POLYEVAL_BLOCK + 1][2], acc[NSHARES][2];
+    uint64_t lo[2][NSHARES], v[4];
+    uint32_t hi[2][NSHARES], words[NSHARES];
+    uint32_t rw[GF_POLYEVAL_WORDS];
+
+    PROFILE_RAND_GADGET(RNG_GADGET_REDUCECOMPARISONS_GF);
+
+    random_uint32_n(rw, GF_POLYEVAL_WORDS);
+    for (size_t i = 0; i < GF_POLYEVAL_WORDS; i++)
+    {
+        r[i / 2] |= ((uint64_t)rw[i]) << (32 * (i % 2));
+    }
+
+    // r^0 .. r^GF_POLYEVAL_BLOCK
+    power[0][0] = 1;
+    power[0][1] = 0;
+    for (size_t t = 1; t <= GF_POLYEVAL_BLOCK; t++)
+    {
+        gf_mul_unreduced(v, power[t - 1], r);
+        gf_reduce(v, GF_POLYEVAL_BITS);
+        power[t][0] = v[0];
+        power[t][1] = v[1];
+    }
+
+    for (size_t j = 0; j < NSHARES; j++)
+    {
+        acc[j][0] = acc[j][1] = 0;
+    }
 
+    // highest block first
+    for (size_t b = (m + GF_POLYEVAL_BLOCK - 1) / GF_POLYEVAL_BLOCK; b-- > 0;)
+    {
         for (size_t j = 0; j < NSHARES; j++)
         {
-            for (size_t k = 0; k < 32; k++)
+            lo[0][j] = lo[1][j] = 0;
+            hi[0][j] = hi[1][j] = 0;
+        }
+
+        for (size_t t = 0; t < GF_POLYEVAL_BLOCK && b * GF_POLYEVAL_BLOCK + t < m; t++)
+        {
+            size_t idx = b * GF_POLYEVAL_BLOCK + t;
+
+            for (size_t j = 0; j < NSHARES; j++)
             {
-                biti = (BC_Bitsliced[i][j] >> k) & 1;
-                tmp = R * biti;
-                E->LSB[j] ^= tmp << k;
-                E->MSB[j] ^= tmp >> (64 - k);
+                words[j] = lane_word(&BC_Bitsliced[idx / LANE_WORDS][j], idx % LANE_WORDS);
             }
+
+            clmul64x32_xor(NSHARES, lo[0], hi[0], power[t][0], words);
+        #if GF_POLYEVAL_BITS > 64
+            clmul64x32_xor(NSHARES, lo[1], hi[1], power[t][1], words);
+        #endif
+        }
+
+        for (size_t j = 0; j < NSHARES; j++)
+        {
+            gf_mul_unreduced(v, acc[j], power[GF_POLYEVAL_BLOCK]);
+            v[0] ^= lo[0][j];
+            v[1] ^= hi[0][j] ^ lo[1][j];
+            v[2] ^= hi[1][j];
+            gf_reduce(v, GF_POLYEVAL_BITS);
+            acc[j][0] = v[0];
+            acc[j][1] = v[1];
+        }
+    }
+
+    for (size_t j = 0; j < NSHARES; j++)
+    {
+        for (size_t i = 0; i < GF_POLYEVAL_WORDS; i++)
+        {
+            E[i][j] = (uint32_t)(acc[j][i / 2] >> (32 * (i % 2)));
         }
     }
-}
\ No newline at end of file
+
+    PROFILE_RAND_GADGET_END();
+}
+
+// number of 32-bit random words drawn per call
+size_t ReduceComparisons_rand_words()
+{
+    return 2 * (NCOEFFS_B + NCOEFFS_C);
+}
+
+size_t ReduceComparisons_GF_rand_words(size_t nwords)
+{
+    return nwords * (SIMPLECOMPBITS) * LANE_WORDS;
+}
+
+size_t ReduceComparisons_GF_polyeval_rand_words()
+{
+    return GF_POLYEVAL_WORDS;
+}
@@ -30,20 +30,79 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "params.h"
+#include "Lane.h"
 
 #ifdef DEBUG
 #include <stdio.h>
 #include <assert.h>
 #endif
 
-struct uint96_t
+/*
+* GF: the rows are reduced to GF_REDUCE_BITS bits (32, 64, 96 or 128) with random elements of GF(2^GF_REDUCE_BITS).
+* A non-zero input reduces to zero with probability 2^-GF_REDUCE_BITS, for GF_REDUCE_WORDS random words per row word,
+* and the equality test takes GF_REDUCE_WORDS - 1 + 5 SecAND's.
+*/
+#ifndef GF_REDUCE_BITS
+    #define GF_REDUCE_BITS 64
+#endif
+
+#if GF_REDUCE_BITS != 32 && GF_REDUCE_BITS != 64 && GF_REDUCE_BITS != 96 && GF_REDUCE_BITS != 128
+    #error "GF_REDUCE_BITS must be 32, 64, 96 or 128"
+#endif
+
+#define GF_REDUCE_WORDS (GF_REDUCE_BITS / 32)
+
+#ifndef GF_REDUCE_BATCH
+    #define GF_REDUCE_BATCH 16 // words whose random R's are drawn in one request
+#endif
+
+void ReduceComparisons(uint64_t E[NSHARES], const uint64_t D[NCOEFFS_B + NCOEFFS_C][NSHARES]);
+
+// the same sum over coefficients given a batch at a time (ARITH_STREAMING): init, then one update per batch
+void ReduceComparisons_init(uint64_t E[NSHARES]);
+void ReduceComparisons_update(uint64_t E[NSHARES], size_t count, const uint64_t D[count][NSHARES]);
+
+// E has nwords = GF_REDUCE_WORDS rows for MaskedComparison_GF, BENCH_GF_REDUCE runs every width
+void ReduceComparisons_GF(size_t nwords, uint32_t E[][NSHARES], lane_t BC_Bitsliced[SIMPLECOMPBITS][NSHARES]);
+
+/*
+* The same reduction on rows given a few at a time (GF_STREAMING): init, one absorb per batch of rows in the order of
+* BC_Bitsliced, then finish. The state holds the unreduced products of every share.
+*/
+struct gf_reduce_state
 {
-    uint64_t LSB[NSHARES];
-    uint32_t MSB[NSHARES];
+    size_t nwords;
+    uint64_t lo[2][NSHARES];
+    uint32_t hi[2][NSHARES];
 };
 
-void ReduceComparisons(uint64_t E[NSHARES], const uint64_t D[NCOEFFS_B + NCOEFFS_C][NSHARES]);
+void ReduceComparisons_GF_init(struct gf_reduce_state *state, size_t nwords);
+void ReduceComparisons_GF_absorb(struct gf_reduce_state *state, size_t nrows, lane_t rows[nrows][NSHARES]);
+void ReduceComparisons_GF_finish(const struct gf_reduce_state *state, uint32_t E[][NSHARES]);
+
+/*
+* GF_POLYEVAL: the 32-bit words of the rows, in the order of ReduceComparisons_GF, are the coefficients of a polynomial
+* evaluated at one random point of GF(2^GF_POLYEVAL_BITS), so only GF_POLYEVAL_WORDS random words are drawn.
+* A non-zero input evaluates to zero with probability at most (SIMPLECOMPBITS * LANE_WORDS - 1) / 2^GF_POLYEVAL_BITS.
+*/
+#ifndef GF_POLYEVAL_BITS
+    #define GF_POLYEVAL_BITS 96
+#endif
+
+#if GF_POLYEVAL_BITS != 64 && GF_POLYEVAL_BITS != 96 && GF_POLYEVAL_BITS != 128
+    #error "GF_POLYEVAL_BITS must be 64, 96 or 128"
+#endif
+
+#define GF_POLYEVAL_WORDS (GF_POLYEVAL_BITS / 32)
+
+#ifndef GF_POLYEVAL_BLOCK
+    #define GF_POLYEVAL_BLOCK 16 // words per step of Horner's rule, see ReduceComparisons.c
+#endif
+
+void ReduceComparisons_GF_polyeval(uint32_t E[GF_POLYEVAL_WORDS][NSHARES], lane_t BC_Bitsliced[SIMPLECOMPBITS][NSHARES]);
 
-void ReduceComparisons_GF(struct uint96_t *E, uint32_t BC_Bitsliced[SIMPLECOMPBITS][NSHARES]);
+size_t ReduceComparisons_rand_words(void);
+size_t ReduceComparisons_GF_rand_words(size_t nwords);
+size_t ReduceComparisons_GF_polyeval_rand_words(void);
 
 #endif // REDUCECOMPARISONS_H
\ No newline at end of file
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Refresh.h"
+#include "randombytes.h"
+
+// [https://eprint.iacr.org/2018/381.pdf, Algorithm 8]
+void RefreshXOR(size_t from, size_t to, uint64_t x[to])
+{
+    PROFILE_RAND_GADGET(RNG_GADGET_REFRESHXOR);
+
+    for (size_t i = from; i < to; i++)
+    {
+        x[i] = 0;
+    }
+
+    for (size_t i = 0; i < to - 1; i++)
+    {
+        for (size_t j = i + 1; j < to; j++)
+        {
+            uint64_t R = random_uint64();
+            x[i] ^= R;
+            x[j] ^= R;
+        }
+    }
+
+    PROFILE_RAND_GADGET_END();
+}
+
+void RefreshXOR32(size_t from, size_t to, uint32_t x[to])
+{
+    PROFILE_RAND_GADGET(RNG_GADGET_REFRESHXOR32);
+
+    for (size_t i = from; i < to; i++)
+    {
+        x[i] = 0;
+    }
+
+    for (size_t i = 0; i < to - 1; i++)
+    {
+        for (size_t j = i + 1; j < to; j++)
+        {
+            uint32_t R = random_uint32();
+            x[i] ^= R;
+            x[j] ^= R;
+        }
+    }
+
+    PROFILE_RAND_GADGET_END();
+}
+
+#ifdef LANE_VECTOR
+void RefreshXORL(size_t from, size_t to, lane_t x[to])
+{
+    PROFILE_RAND_GADGET(RNG_GADGET_REFRESHXOR_LANE);
+
+    for (size_t i = from; i < to; i++)
+    {
+        x[i] = (lane_t){0};
+    }
+
+    for (size_t i = 0; i < to - 1; i++)
+    {
+        for (size_t j = i + 1; j < to; j++)
+        {
+            lane_t R = random_lane();
+            x[i] ^= R;
+            x[j] ^= R;
+        }
+    }
+
+    PROFILE_RAND_GADGET_END();
+}
+#endif
+
+// bit planes are [nbits][nshares]: the randomness of all planes is one bulk request, every plane is refreshed as a contiguous sharing
+void RefreshXOR_bitsliced(size_t from, size_t to, size_t nbits, lane_t x[nbits][to])
+{
+    PROFILE_RAND_GADGET(RNG_GADGET_REFRESHXOR_BITSLICED);
+
+    lane_t R[nbits * (to * (to - 1) / 2) + 1];
+    size_t r = 0;
+
+    random_lane_n(R, nbits * (to * (to - 1) / 2));
+
+    for (size_t i = from; i < to; i++)
+    {
+        for (size_t k = 0; k < nbits; k++)
+        {
+            x[k][i] = (lane_t){0};
+        }
+    }
+
+    for (size_t k = 0; k < nbits; k++)
+    {
+        for (size_t i = 0; i < to - 1; i++)
+        {
+            for (size_t j = i + 1; j < to; j++)
+            {
+                x[k][i] ^= R[r];
+                x[k][j] ^= R[r++];
+            }
+        }
+    }
+
+    PROFILE_RAND_GADGET_END();
+}
+
+// number of 32-bit random words drawn per call on nshares shares
+size_t RefreshXOR_rand_words(size_t nshares)
+{
+    return nshares * (nshares - 1);
+}
+
+size_t RefreshXOR32_rand_words(size_t nshares)
+{
+    return nshares * (nshares - 1) / 2;
+}
+
+size_t RefreshXOR_bitsliced_rand_words(size_t nshares, size_t nbits)
+{
+    return nshares * (nshares - 1) / 2 * nbits * LANE_WORDS;
+}
+
+#ifdef LANE_VECTOR
+size_t RefreshXORL_rand_words(size_t nshares)
+{
+    return nshares * (nshares - 1) / 2 * LANE_WORDS;
+}
+#endif
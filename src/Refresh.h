@@ -0,0 +1,52 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef REFRESH_H
+#define REFRESH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Lane.h"
+
+/*
+* Shares from..to-1 are set to zero, then all to shares are refreshed pairwise.
+* With from = to, this is a plain refresh of an existing sharing.
+*/
+void RefreshXOR(size_t from, size_t to, uint64_t x[to]);
+void RefreshXOR32(size_t from, size_t to, uint32_t x[to]);
+void RefreshXOR_bitsliced(size_t from, size_t to, size_t nbits, lane_t x[nbits][to]);
+#ifdef LANE_VECTOR
+void RefreshXORL(size_t from, size_t to, lane_t x[to]);
+#endif
+
+size_t RefreshXOR_rand_words(size_t nshares);
+size_t RefreshXOR32_rand_words(size_t nshares);
+size_t RefreshXOR_bitsliced_rand_words(size_t nshares, size_t nbits);
+#ifdef LANE_VECTOR
+size_t RefreshXORL_rand_words(size_t nshares);
+#endif
+
+#endif // REFRESH_H
@@ -26,13 +26,15 @@
 
 #include "SecAdd.h"
 #include "SecAnd.h"
+#include "Refresh.h"
 #include "randombytes.h"
+#include <string.h>
 
 #ifdef DEBUG
 #include "bitmask.h"
 #endif
 
-static void SecXOR32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares])
+static void SecXORL(size_t nshares, lane_t z[nshares], const lane_t x[nshares], const lane_t y[nshares])
 {
 	for (size_t i = 0; i < nshares; i++)
 	{
@@ -40,7 +42,8 @@ static void SecXOR32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshar
 	}
 }
 
-static void SecXOR64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares])
+#ifdef SECADD_RIPPLE
+static void SecXOR32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares])
 {
 	for (size_t i = 0; i < nshares; i++)
 	{
@@ -48,45 +51,220 @@ static void SecXOR64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshar
 	}
 }
 
-static void get_bit(size_t nshares, size_t nbits, uint32_t x_bit[nshares], const uint32_t x[nshares][nbits], size_t bit)
+static void SecXOR64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares])
 {
 	for (size_t i = 0; i < nshares; i++)
 	{
-		x_bit[i] = x[i][bit];
+		z[i] = x[i] ^ y[i];
 	}
 }
+#endif
 
-static void write_bit(size_t nshares, size_t nbits, uint32_t x[nshares][nbits], const uint32_t x_bit[nshares], size_t bit)
+#ifdef DEBUG
+static void SecAdd_bitsliced_check(size_t nshares, size_t nbits, const lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t y[nbits][nshares])
 {
-	for (size_t i = 0; i < nshares; i++)
+	for (size_t i = 0; i < LANE_BITS; i++)
 	{
-		x[i][bit] = x_bit[i];
+		uint32_t x_unmasked = 0;
+		uint32_t y_unmasked = 0;
+		uint32_t z_unmasked = 0;
+
+		for (size_t j = 0; j < nshares; j++)
+		{
+			for (size_t k = 0; k < nbits; k++)
+			{
+				x_unmasked = (x_unmasked ^ (lane_bit(&x[k][j], i) << k)) & bit_mask(nbits);
+				y_unmasked = (y_unmasked ^ (lane_bit(&y[k][j], i) << k)) & bit_mask(nbits);
+				z_unmasked = (z_unmasked ^ (lane_bit(&z[k][j], i) << k)) & bit_mask(nbits);
+			}
+		}
+
+		assert(z_unmasked == ((x_unmasked + y_unmasked) & bit_mask(nbits)));
 	}
 }
+#endif
+
+// fixed-share versions of the adders below: identical data flow, SecAND's for the same N (and lane width W) called directly
+#define SECADD_BITSLICED_FIXED(N, W)                                                                                            \
+	static void SecAdd_bitsliced_##N(size_t nbits, lane_t z[nbits][N], const lane_t x[nbits][N], const lane_t y[nbits][N])      \
+	{                                                                                                                           \
+		lane_t xANDy[nbits][N];                                                                                                 \
+		lane_t xXORy[N], carry[N], cANDxXORy[N];                                                                                \
+                                                                                                                                \
+		if (nbits > 1)                                                                                                          \
+		{                                                                                                                       \
+			SecAND##W##_batch_##N(nbits - 1, xANDy, x, y);                                                                      \
+			memcpy(carry, xANDy[0], sizeof(carry));                                                                             \
+		}                                                                                                                       \
+                                                                                                                                \
+		FIXED_UNROLL                                                                                                            \
+		for (size_t k = 0; k < N; k++)                                                                                          \
+		{                                                                                                                       \
+			z[0][k] = x[0][k] ^ y[0][k];                                                                                        \
+		}                                                                                                                       \
+                                                                                                                                \
+		for (size_t i = 1; i < nbits; i++)                                                                                      \
+		{                                                                                                                       \
+			FIXED_UNROLL                                                                                                        \
+			for (size_t k = 0; k < N; k++)                                                                                      \
+			{                                                                                                                   \
+				xXORy[k] = x[i][k] ^ y[i][k];                                                                                   \
+				z[i][k] = xXORy[k] ^ carry[k];                                                                                  \
+			}                                                                                                                   \
+                                                                                                                                \
+			if (i != nbits - 1)                                                                                                 \
+			{                                                                                                                   \
+				SecAND##W##_##N(cANDxXORy, carry, xXORy);                                                                       \
+				FIXED_UNROLL                                                                                                    \
+				for (size_t k = 0; k < N; k++)                                                                                  \
+				{                                                                                                               \
+					carry[k] = cANDxXORy[k] ^ xANDy[i][k];                                                                      \
+				}                                                                                                               \
+			}                                                                                                                   \
+		}                                                                                                                       \
+	}
+
+#ifdef SECADD_RIPPLE
+
+#define SECADD_FIXED(N, W, NAME)                                                                                                \
+	static void NAME##_##N(uint##W##_t z[N], const uint##W##_t x[N], const uint##W##_t y[N])                                     \
+	{                                                                                                                           \
+		uint##W##_t xXORy[N], xANDy[N], acc[N];                                                                                 \
+		uint32_t c_bit[N], xXORy_bit[N], cANDxXORy_bit[N];                                                                      \
+                                                                                                                                \
+		SecAND##W##_##N(xANDy, x, y);                                                                                           \
+                                                                                                                                \
+		FIXED_UNROLL                                                                                                            \
+		for (size_t i = 0; i < N; i++)                                                                                          \
+		{                                                                                                                       \
+			xXORy[i] = x[i] ^ y[i];                                                                                             \
+			acc[i] = 0;                                                                                                         \
+			c_bit[i] = 0;                                                                                                       \
+		}                                                                                                                       \
+                                                                                                                                \
+		for (size_t j = 0; j < W - 1; j++)                                                                                      \
+		{                                                                                                                       \
+			FIXED_UNROLL                                                                                                        \
+			for (size_t i = 0; i < N; i++)                                                                                      \
+			{                                                                                                                   \
+				xXORy_bit[i] = (xXORy[i] >> j) & 0x1;                                                                           \
+			}                                                                                                                   \
+                                                                                                                                \
+			SecAND32_##N(cANDxXORy_bit, c_bit, xXORy_bit);                                                                      \
+                                                                                                                                \
+			FIXED_UNROLL                                                                                                        \
+			for (size_t i = 0; i < N; i++)                                                                                      \
+			{                                                                                                                   \
+				c_bit[i] = ((xANDy[i] >> j) & 0x1) ^ cANDxXORy_bit[i];                                                          \
+				acc[i] |= (uint##W##_t)(c_bit[i] & 0x1) << (j + 1);                                                             \
+			}                                                                                                                   \
+		}                                                                                                                       \
+                                                                                                                                \
+		FIXED_UNROLL                                                                                                            \
+		for (size_t i = 0; i < N; i++)                                                                                          \
+		{                                                                                                                       \
+			z[i] = xXORy[i] ^ acc[i];                                                                                           \
+		}                                                                                                                       \
+	}
+
+#define SECADD64_FIXED(N) SECADD_FIXED(N, 64, SecAdd)
+#define SECADD32_FIXED(N) SECADD_FIXED(N, 32, SecAdd32)
 
+#else
 
-void SecAdd_bitsliced(size_t nshares, size_t nbits, uint32_t z[nshares][nbits], const uint32_t x[nshares][nbits], const uint32_t y[nshares][nbits])
+/*
+* Kogge-Stone adder [https://eprint.iacr.org/2014/891.pdf]: generate G and propagate P on whole masked words,
+* the carries of 2s bits from those of s bits. W - 1 bits of carry take log2(W) rounds: one SecAND, then two per round
+* with s = 1 .. W/4, then one for s = W/2. Both SecAND's of a round read the old P, so they form one batch.
+* P << s shares its masks with P and is refreshed before they are ANDed.
+*/
+#define SECADD_KS(N, W, AND, AND_BATCH, REFRESH)                                                                                \
+	{                                                                                                                           \
+		uint##W##_t G[N], lhs[2][N], rhs[2][N], out[2][N];                                                                      \
+		uint##W##_t *P = lhs[0];                                                                                                \
+                                                                                                                                \
+		AND(N, G, x, y);                                                                                                        \
+                                                                                                                                \
+		FIXED_UNROLL                                                                                                            \
+		for (size_t i = 0; i < N; i++)                                                                                          \
+		{                                                                                                                       \
+			P[i] = x[i] ^ y[i];                                                                                                 \
+		}                                                                                                                       \
+                                                                                                                                \
+		for (size_t s = 1; s < W / 2; s <<= 1)                                                                                  \
+		{                                                                                                                       \
+			FIXED_UNROLL                                                                                                        \
+			for (size_t i = 0; i < N; i++)                                                                                      \
+			{                                                                                                                   \
+				lhs[1][i] = P[i];                                                                                               \
+				rhs[0][i] = G[i] << s;                                                                                          \
+				rhs[1][i] = P[i] << s;                                                                                          \
+			}                                                                                                                   \
+                                                                                                                                \
+			REFRESH(N, N, rhs[1]);                                                                                              \
+			AND_BATCH(N, 2, out, lhs, rhs);                                                                                     \
+                                                                                                                                \
+			FIXED_UNROLL                                                                                                        \
+			for (size_t i = 0; i < N; i++)                                                                                      \
+			{                                                                                                                   \
+				G[i] ^= out[0][i];                                                                                              \
+				P[i] = out[1][i];                                                                                               \
+			}                                                                                                                   \
+		}                                                                                                                       \
+                                                                                                                                \
+		FIXED_UNROLL                                                                                                            \
+		for (size_t i = 0; i < N; i++)                                                                                          \
+		{                                                                                                                       \
+			rhs[0][i] = G[i] << (W / 2);                                                                                        \
+		}                                                                                                                       \
+                                                                                                                                \
+		AND(N, out[0], P, rhs[0]);                                                                                              \
+                                                                                                                                \
+		FIXED_UNROLL                                                                                                            \
+		for (size_t i = 0; i < N; i++)                                                                                          \
+		{                                                                                                                       \
+			G[i] ^= out[0][i];                                                                                                  \
+			z[i] = x[i] ^ y[i] ^ (G[i] << 1);                                                                                   \
+		}                                                                                                                       \
+	}
+
+#define SECADD_FIXED(N, W, NAME, REFRESH)                                                                                       \
+	static void NAME##_##N(uint##W##_t z[N], const uint##W##_t x[N], const uint##W##_t y[N])                                    \
+	SECADD_KS(N, W, SecAND##W, SecAND##W##_batch, REFRESH)
+
+#define SECADD64_FIXED(N) SECADD_FIXED(N, 64, SecAdd, RefreshXOR)
+#define SECADD32_FIXED(N) SECADD_FIXED(N, 32, SecAdd32, RefreshXOR32)
+
+#endif
+
+#define SECADD_BITSLICED_LANE_FIXED(N) LANE_APPLY(SECADD_BITSLICED_FIXED, N, LANE_BITS)
+
+FIXED_INSTANTIATE(SECADD_BITSLICED_LANE_FIXED)
+FIXED_INSTANTIATE(SECADD64_FIXED)
+FIXED_INSTANTIATE(SECADD32_FIXED)
+
+
+void SecAdd_bitsliced(size_t nshares, size_t nbits, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t y[nbits][nshares])
 {
-	uint32_t xANDy[nshares], xXORy[nshares], cANDxXORy[nshares];
-	uint32_t carry[nshares], sum[nshares];
-	uint32_t x_bit[nshares], y_bit[nshares];
+	FIXED_DISPATCH(nshares, SecAdd_bitsliced, (nbits, z, x, y));
 
-	get_bit(nshares, nbits, x_bit, x, 0);
-	get_bit(nshares, nbits, y_bit, y, 0);
+	// the bit planes are [nbits][nshares]: x AND y of all bits that produce a carry is one batch straight from x and y
+	lane_t xANDy[nbits][nshares];
+	lane_t xXORy[nshares], carry[nshares], cANDxXORy[nshares];
 
-	SecAND32(nshares, carry, x_bit, y_bit);
-	SecXOR32(nshares, sum, x_bit, y_bit);
+	if (nbits > 1)
+	{
+		SecANDL_batch(nshares, nbits - 1, xANDy, x, y);
+		memcpy(carry, xANDy[0], nshares * sizeof(lane_t));
+	}
 
-	write_bit(nshares, nbits, z, sum, 0);
+	SecXORL(nshares, z[0], x[0], y[0]);
 
 	for (size_t i = 1; i < nbits; i++)  
 	{
-		get_bit(nshares, nbits, x_bit, x, i);
-		get_bit(nshares, nbits, y_bit, y, i);
-
 		// sum
-		SecXOR32(nshares, xXORy, x_bit, y_bit);
-		SecXOR32(nshares, sum, xXORy, carry);
+		SecXORL(nshares, xXORy, x[i], y[i]);
+		SecXORL(nshares, z[i], xXORy, carry);
 
 		/* carry out : implemented with (2) to reduce SecAND's
 		*  	(1) c_out = (c_in AND x) XOR (c_in AND y) XOR (x AND y) [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 2]
@@ -94,32 +272,273 @@ void SecAdd_bitsliced(size_t nshares, size_t nbits, uint32_t z[nshares][nbits],
 		*/
 		if (i != nbits - 1) //* nbits - 1 because we don't need final carry
 		{
-			SecAND32(nshares, xANDy, x_bit, y_bit);
-			SecAND32(nshares, cANDxXORy, xXORy, carry);
-			SecXOR32(nshares, carry, cANDxXORy, xANDy);
+			SecANDL(nshares, cANDxXORy, carry, xXORy);
+			SecXORL(nshares, carry, cANDxXORy, xANDy[i]);
+		}
+	}
+
+#ifdef DEBUG
+	SecAdd_bitsliced_check(nshares, nbits, z, x, y);
+#endif
+}
+
+/*
+* Parallel-prefix bitsliced adders: the carries into bits 1 .. nbits-1 are the prefix generates of the
+* m = nbits - 1 lower (generate, propagate) nodes. At every level of the network, node t absorbs node s < t:
+*	G_t = G_t ^ (P_t AND G_s),	P_t = P_t AND P_s
+* All absorptions of a level are independent and go into one SecANDL_batch. P_t then enters two SecAND's, so
+* P_s is refreshed before the second one, as in the Kogge-Stone SecAdd above. P_t is only computed if a later
+* level reads it.
+*/
+#define PREFIX_MAXLEVELS 10 // Brent-Kung for m = 31: 2 * floor(log2(31))
+
+struct prefix_network
+{
+	size_t nlevels;
+	size_t nops[PREFIX_MAXLEVELS];
+	uint8_t t[PREFIX_MAXLEVELS][32], s[PREFIX_MAXLEVELS][32], needp[PREFIX_MAXLEVELS][32];
+};
+
+static size_t floor_log2(size_t m)
+{
+	size_t l = 0;
+
+	while (((size_t)2 << l) <= m)
+	{
+		l++;
+	}
+
+	return l;
+}
+
+static void prefix_network(struct prefix_network *net, enum adder_topology adder, size_t m)
+{
+	size_t up = floor_log2(m);
+	size_t span = (((size_t)1 << up) < m) ? up + 1 : up; // ceil(log2(m))
+
+	net->nlevels = (adder == ADDER_BRENT_KUNG) ? 2 * up : span;
+
+	for (size_t l = 0; l < net->nlevels; l++)
+	{
+		size_t nops = 0;
+		size_t d;
+
+		switch (adder)
+		{
+		case ADDER_KOGGE_STONE: // every node absorbs the node at distance 2^l
+			d = (size_t)1 << l;
+			for (size_t i = d; i < m; i++)
+			{
+				net->t[l][nops] = i;
+				net->s[l][nops++] = i - d;
+			}
+			break;
+
+		case ADDER_SKLANSKY: // the upper half of every 2^(l+1) block absorbs the top node of the lower half
+			d = (size_t)1 << l;
+			for (size_t i = 0; i < m; i++)
+			{
+				if (i & d)
+				{
+					net->t[l][nops] = i;
+					net->s[l][nops++] = (i & ~(2 * d - 1)) + d - 1;
+				}
+			}
+			break;
+
+		default: // ADDER_BRENT_KUNG: up-sweep over the first floor(log2(m)) levels, down-sweep over the others
+			d = (l < up) ? (size_t)1 << l : (size_t)1 << (2 * up - 1 - l);
+			for (size_t i = (l < up) ? 2 * d - 1 : 3 * d - 1; i < m; i += 2 * d)
+			{
+				net->t[l][nops] = i;
+				net->s[l][nops++] = i - d;
+			}
+			break;
+		}
+
+		net->nops[l] = nops;
+	}
+
+	// backwards: P_t of an absorption is needed if a later level reads it, either as P_t or as P_s
+	uint8_t live[32] = {0};
+
+	for (size_t l = net->nlevels; l-- > 0;)
+	{
+		for (size_t j = 0; j < net->nops[l]; j++)
+		{
+			net->needp[l][j] = live[net->t[l][j]];
+		}
+		for (size_t j = 0; j < net->nops[l]; j++)
+		{
+			live[net->t[l][j]] = 1;
 		}
+		for (size_t j = 0; j < net->nops[l]; j++)
+		{
+			if (net->needp[l][j])
+			{
+				live[net->s[l][j]] = 1;
+			}
+		}
+	}
+}
+
+static void SecAdd_bitsliced_prefix(size_t nshares, size_t nbits, enum adder_topology adder, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t y[nbits][nshares])
+{
+	size_t m = nbits - 1;
+	struct prefix_network net;
+
+	prefix_network(&net, adder, m);
 
-		write_bit(nshares, nbits, z, sum, i);
+	lane_t G[m][nshares], P[m][nshares];
+	lane_t lhs[2 * m][nshares], rhs[2 * m][nshares], prod[2 * m][nshares];
+
+	// generates of the m lower bits straight from the bit planes, propagates as their XOR
+	SecANDL_batch(nshares, m, G, x, y);
+
+	for (size_t k = 0; k < m; k++)
+	{
+		SecXORL(nshares, P[k], x[k], y[k]);
 	}
 
+	for (size_t l = 0; l < net.nlevels; l++)
+	{
+		size_t K = 0;
+
+		for (size_t j = 0; j < net.nops[l]; j++)
+		{
+			size_t t = net.t[l][j], s = net.s[l][j];
+
+			memcpy(lhs[K], P[t], nshares * sizeof(lane_t));
+			memcpy(rhs[K], G[s], nshares * sizeof(lane_t));
+			K++;
+
+			if (net.needp[l][j])
+			{
+				memcpy(lhs[K], P[t], nshares * sizeof(lane_t));
+				memcpy(rhs[K], P[s], nshares * sizeof(lane_t));
+				RefreshXORL(nshares, nshares, rhs[K]);
+				K++;
+			}
+		}
+
+		SecANDL_batch(nshares, K, prod, lhs, rhs);
+
+		K = 0;
+		for (size_t j = 0; j < net.nops[l]; j++)
+		{
+			size_t t = net.t[l][j];
+
+			SecXORL(nshares, G[t], G[t], prod[K++]);
+
+			if (net.needp[l][j])
+			{
+				memcpy(P[t], prod[K], nshares * sizeof(lane_t));
+				K++;
+			}
+		}
+	}
+
+	SecXORL(nshares, z[0], x[0], y[0]);
+
+	for (size_t k = 1; k < nbits; k++)
+	{
+		SecXORL(nshares, z[k], x[k], y[k]);
+		SecXORL(nshares, z[k], z[k], G[k - 1]);
+	}
+}
+
+void SecAdd_bitsliced_adder(size_t nshares, size_t nbits, enum adder_topology adder, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t y[nbits][nshares])
+{
+	if (adder == ADDER_RIPPLE || nbits < 3)
+	{
+		SecAdd_bitsliced(nshares, nbits, z, x, y);
+		return;
+	}
+
+#ifdef DEBUG
+	assert(nbits <= 32);
+#endif
+
+	SecAdd_bitsliced_prefix(nshares, nbits, adder, z, x, y);
+
+#ifdef DEBUG
+	SecAdd_bitsliced_check(nshares, nbits, z, x, y);
+#endif
+}
+
+/*
+* z = x + c for a public bitsliced c, where c[k] holds bit k of the LANE_BITS public values. An AND with a public bit is
+* linear (share-wise), so only the carry needs a SecAND:
+*	c_out = (x AND c) XOR (c_in AND (x XOR c))
+* This is nbits - 2 SecAND's, against 2 nbits - 3 for SecAdd_bitsliced with a shared c.
+*/
+void SecConstAdd_bitsliced(size_t nshares, size_t nbits, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t c[nbits])
+{
+	lane_t xXORc[nshares], carry[nshares], cANDxXORc[nshares];
+
 #ifdef DEBUG
-	for (size_t i = 0; i < 32; i++)
+	lane_t x_unmasked[nbits];
+
+	for (size_t k = 0; k < nbits; k++)
 	{
-		uint32_t x_unmasked = 0;
-		uint32_t y_unmasked = 0;
-		uint32_t z_unmasked = 0;
+		x_unmasked[k] = (lane_t){0};
+		for (size_t i = 0; i < nshares; i++)
+		{
+			x_unmasked[k] ^= x[k][i];
+		}
+	}
+#endif
 
-		for (size_t j = 0; j < nshares; j++)
+	for (size_t i = 0; i < nshares; i++)
+	{
+		carry[i] = x[0][i] & c[0];
+		z[0][i] = x[0][i];
+	}
+	z[0][0] ^= c[0];
+
+	for (size_t k = 1; k < nbits; k++)
+	{
+		memcpy(xXORc, x[k], nshares * sizeof(lane_t));
+		xXORc[0] ^= c[k];
+
+		if (k == nbits - 1)
 		{
-			for (size_t k = 0; k < nbits; k++)
+			SecXORL(nshares, z[k], xXORc, carry);
+			break;
+		}
+
+		SecANDL(nshares, cANDxXORc, carry, xXORc);
+
+		// sum and carry out, x is read before z is written so that z may alias x
+		for (size_t i = 0; i < nshares; i++)
+		{
+			lane_t sum = xXORc[i] ^ carry[i];
+
+			carry[i] = (x[k][i] & c[k]) ^ cANDxXORc[i];
+			z[k][i] = sum;
+		}
+	}
+
+#ifdef DEBUG
+	for (size_t i = 0; i < LANE_BITS; i++)
+	{
+		uint32_t xi = 0, ci = 0, zi = 0;
+
+		for (size_t k = 0; k < nbits; k++)
+		{
+			lane_t z_unmasked = {0};
+
+			for (size_t j = 0; j < nshares; j++)
 			{
-				x_unmasked = (x_unmasked ^ (((x[j][k] & (1 << i)) >> i) << k)) & bit_mask(nbits);
-				y_unmasked = (y_unmasked ^ (((y[j][k] & (1 << i)) >> i) << k)) & bit_mask(nbits);
-				z_unmasked = (z_unmasked ^ (((z[j][k] & (1 << i)) >> i) << k)) & bit_mask(nbits);
+				z_unmasked ^= z[k][j];
 			}
+
+			xi |= lane_bit(&x_unmasked[k], i) << k;
+			ci |= lane_bit(&c[k], i) << k;
+			zi |= lane_bit(&z_unmasked, i) << k;
 		}
 
-		assert(z_unmasked == ((x_unmasked + y_unmasked) & bit_mask(nbits)));
+		assert(zi == ((xi + ci) & bit_mask(nbits)));
 	}
 #endif
 }
@@ -127,10 +546,14 @@ void SecAdd_bitsliced(size_t nshares, size_t nbits, uint32_t z[nshares][nbits],
 /*
 * [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf]
 *
-* This is roughly Algorithm 3: we make the same optimisation (1 SecAND in the loop), but keep everything bit-wise
+* With SECADD_RIPPLE, this is roughly Algorithm 3: we make the same optimisation (1 SecAND in the loop), but keep everything bit-wise.
+* By default, the Kogge-Stone adder (SECADD_KS) is used instead.
 */
 void SecAdd(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares])
 {
+	FIXED_DISPATCH(nshares, SecAdd, (z, x, y));
+
+#ifdef SECADD_RIPPLE
 	uint64_t xXORy[nshares], xANDy[nshares];
 	uint32_t c_bit[nshares], xANDy_bit[nshares], cANDxXORy_bit[nshares], xXORy_bit[nshares];
 
@@ -163,6 +586,9 @@ void SecAdd(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], cons
 	}
 
 	SecXOR64(nshares, z, xXORy, z);
+#else
+	SECADD_KS(nshares, 64, SecAND64, SecAND64_batch, RefreshXOR)
+#endif
 
 #ifdef DEBUG
 	uint64_t x_unmasked = 0;
@@ -182,6 +608,9 @@ void SecAdd(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], cons
 
 void SecAdd32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares])
 {
+	FIXED_DISPATCH(nshares, SecAdd32, (z, x, y));
+
+#ifdef SECADD_RIPPLE
 	uint32_t xXORy[nshares], xANDy[nshares];
 	uint32_t c_bit[nshares], xANDy_bit[nshares], cANDxXORy_bit[nshares], xXORy_bit[nshares];
 
@@ -214,5 +643,85 @@ void SecAdd32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], co
 	}
 
 	SecXOR32(nshares, z, xXORy, z);
+#else
+	SECADD_KS(nshares, 32, SecAND32, SecAND32_batch, RefreshXOR32)
+#endif
+}
+
+// number of 32-bit random words drawn per call
+size_t SecAdd_rand_words(size_t nshares)
+{
+#ifdef SECADD_RIPPLE
+	return SecAND64_rand_words(nshares) + (64 - 1) * SecAND32_rand_words(nshares);
+#else
+	// 2 + 2 * 5 SecAND64's, a refresh in each of the 5 rounds with s = 1 .. 16
+	return (2 + 2 * 5) * SecAND64_rand_words(nshares) + 5 * RefreshXOR_rand_words(nshares);
+#endif
+}
+
+size_t SecAdd32_rand_words(size_t nshares)
+{
+#ifdef SECADD_RIPPLE
+	return SecAND32_rand_words(nshares) + (32 - 1) * SecAND32_rand_words(nshares);
+#else
+	return (2 + 2 * 4) * SecAND32_rand_words(nshares) + 4 * RefreshXOR32_rand_words(nshares);
+#endif
+}
+
+size_t SecAdd_bitsliced_rand_words(size_t nshares, size_t nbits)
+{
+	// x AND y for every bit but the last, a carry SecAND for every bit in between
+	size_t nand = (nbits > 1) ? 2 * nbits - 3 : 0;
+
+	return nand * SecANDL_rand_words(nshares);
 }
 
+// SecAND's of the bitsliced adder, and of those the ones with a refreshed operand
+static size_t SecAdd_bitsliced_adder_counts(size_t nbits, enum adder_topology adder, size_t *nrefresh)
+{
+	*nrefresh = 0;
+
+	if (adder == ADDER_RIPPLE || nbits < 3)
+	{
+		return (nbits > 1) ? 2 * nbits - 3 : 0;
+	}
+
+	struct prefix_network net;
+	size_t nand = nbits - 1;
+
+	prefix_network(&net, adder, nbits - 1);
+
+	for (size_t l = 0; l < net.nlevels; l++)
+	{
+		for (size_t j = 0; j < net.nops[l]; j++)
+		{
+			nand += 1 + net.needp[l][j];
+			*nrefresh += net.needp[l][j];
+		}
+	}
+
+	return nand;
+}
+
+size_t SecAdd_bitsliced_adder_nand(size_t nbits, enum adder_topology adder)
+{
+	size_t nrefresh;
+
+	return SecAdd_bitsliced_adder_counts(nbits, adder, &nrefresh);
+}
+
+size_t SecAdd_bitsliced_adder_rand_words(size_t nshares, size_t nbits, enum adder_topology adder)
+{
+	size_t nrefresh;
+	size_t nand = SecAdd_bitsliced_adder_counts(nbits, adder, &nrefresh);
+
+	return nand * SecANDL_rand_words(nshares) + nrefresh * RefreshXORL_rand_words(nshares);
+}
+
+size_t SecConstAdd_bitsliced_rand_words(size_t nshares, size_t nbits)
+{
+	// a carry SecAND for every bit in between
+	size_t nand = (nbits > 2) ? nbits - 2 : 0;
+
+	return nand * SecANDL_rand_words(nshares);
+}
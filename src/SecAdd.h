@@ -29,14 +29,33 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "Lane.h"
 
 #ifdef DEBUG
 #include <stdio.h>
 #include <assert.h>
 #endif
 
+// topologies of the bitsliced adder, from fewest SecAND's to fewest sequential SecAND levels
+enum adder_topology
+{
+    ADDER_RIPPLE,      // 2 nbits - 3 SecAND's, nbits - 1 levels
+    ADDER_BRENT_KUNG,  // parallel prefix, 2 floor(log2(nbits - 1)) levels
+    ADDER_SKLANSKY,    // parallel prefix, ceil(log2(nbits - 1)) levels, high fan-out
+    ADDER_KOGGE_STONE  // parallel prefix, ceil(log2(nbits - 1)) levels, most SecAND's
+};
+
 void SecAdd(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares]);
 void SecAdd32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares]);
-void SecAdd_bitsliced(size_t nshares, size_t nbits, uint32_t z[nshares][nbits], const uint32_t x[nshares][nbits], const uint32_t y[nshares][nbits]);
+void SecAdd_bitsliced(size_t nshares, size_t nbits, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t y[nbits][nshares]);
+void SecConstAdd_bitsliced(size_t nshares, size_t nbits, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t c[nbits]);
+void SecAdd_bitsliced_adder(size_t nshares, size_t nbits, enum adder_topology adder, lane_t z[nbits][nshares], const lane_t x[nbits][nshares], const lane_t y[nbits][nshares]);
+
+size_t SecAdd_rand_words(size_t nshares);
+size_t SecAdd32_rand_words(size_t nshares);
+size_t SecAdd_bitsliced_rand_words(size_t nshares, size_t nbits);
+size_t SecAdd_bitsliced_adder_rand_words(size_t nshares, size_t nbits, enum adder_topology adder);
+size_t SecAdd_bitsliced_adder_nand(size_t nbits, enum adder_topology adder);
+size_t SecConstAdd_bitsliced_rand_words(size_t nshares, size_t nbits);
 
 #endif // SECADD_H
\ No newline at end of file
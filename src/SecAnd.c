@@ -27,16 +27,30 @@
 #include "SecAnd.h"
 #include "randombytes.h"
 
-// [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 1]
-void SecAND32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares])
+// [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 1], with the nshares(nshares-1)/2 random words in R
+static void SecAND32_rand(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares], const uint32_t *R)
 {
 	uint32_t r[nshares][nshares];
 
+	SECAND_LOWRAND_DISPATCH(nshares, 32, z, x, y, R)
+
+#ifdef DEBUG
+	uint32_t x_unmasked = 0;
+	uint32_t y_unmasked = 0;
+	uint32_t z_unmasked = 0;
+
+	for (size_t j = 0; j < nshares; j++)
+	{
+		x_unmasked ^= x[j];
+		y_unmasked ^= y[j];
+	}
+#endif
+
 	for (size_t i = 0; i < nshares; i++)
 	{
 		for (size_t j = (i + 1); j < nshares; j++)
 		{
-			r[i][j] = random_uint32();
+			r[i][j] = *R++;
 			r[j][i] = r[i][j] ^ (x[i] & y[j]);
 			r[j][i] = r[j][i] ^ (x[j] & y[i]);
 		}
@@ -55,14 +69,8 @@ void SecAND32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], co
 	}
 
 #ifdef DEBUG
-	uint32_t x_unmasked = 0;
-	uint32_t y_unmasked = 0;
-	uint32_t z_unmasked = 0;
-
 	for (size_t j = 0; j < nshares; j++)
 	{
-		x_unmasked ^= x[j];
-		y_unmasked ^= y[j];
 		z_unmasked ^= z[j];
 	}
 
@@ -70,16 +78,74 @@ void SecAND32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], co
 #endif
 }
 
-// [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 1]
-void SecAND64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares])
+void SecAND32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares])
+{
+	SECAND_SIMD_DISPATCH(nshares, 32, z, x, y)
+	FIXED_DISPATCH(nshares, SecAND32, (z, x, y));
+
+	uint32_t R[SECAND_NRAND(nshares) + 1];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND32);
+
+	for (size_t i = 0; i < SECAND_NRAND(nshares); i++)
+	{
+		R[i] = random_uint32();
+	}
+
+	SecAND32_rand(nshares, z, x, y, R);
+
+	PROFILE_RAND_GADGET_END();
+}
+
+void SecAND32_batch(size_t nshares, size_t K, uint32_t z[K][nshares], const uint32_t x[K][nshares], const uint32_t y[K][nshares])
+{
+	SECAND_SIMD_BATCH_DISPATCH(nshares, 32, K, z, x, y)
+	FIXED_DISPATCH(nshares, SecAND32_batch, (K, z, x, y));
+
+	size_t nrand = SECAND_NRAND(nshares);
+	size_t chunk = (nrand == 0 || nrand > SECAND_BATCH_WORDS) ? 1 : SECAND_BATCH_WORDS / nrand;
+	uint32_t R[chunk * nrand + 1];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND32);
+
+	for (size_t k0 = 0; k0 < K; k0 += chunk)
+	{
+		size_t kn = (K - k0 < chunk) ? (K - k0) : chunk;
+
+		random_uint32_n(R, kn * nrand);
+		for (size_t k = 0; k < kn; k++)
+		{
+			SecAND32_rand(nshares, z[k0 + k], x[k0 + k], y[k0 + k], &R[k * nrand]);
+		}
+	}
+
+	PROFILE_RAND_GADGET_END();
+}
+
+// [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 1], with the nshares(nshares-1)/2 random words in R
+static void SecAND64_rand(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares], const uint64_t *R)
 {
 	uint64_t r[nshares][nshares];
 
+	SECAND_LOWRAND_DISPATCH(nshares, 64, z, x, y, R)
+
+#ifdef DEBUG
+	uint64_t x_unmasked = 0;
+	uint64_t y_unmasked = 0;
+	uint64_t z_unmasked = 0;
+
+	for (size_t j = 0; j < nshares; j++)
+	{
+		x_unmasked ^= x[j];
+		y_unmasked ^= y[j];
+	}
+#endif
+
 	for (size_t i = 0; i < nshares; i++)
 	{
 		for (size_t j = (i + 1); j < nshares; j++)
 		{
-			r[i][j] = random_uint64();
+			r[i][j] = *R++;
 			r[j][i] = r[i][j] ^ (x[i] & y[j]);
 			r[j][i] = r[j][i] ^ (x[j] & y[i]);
 		}
@@ -98,17 +164,168 @@ void SecAND64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], co
 	}
 
 #ifdef DEBUG
-	uint64_t x_unmasked = 0;
-	uint64_t y_unmasked = 0;
-	uint64_t z_unmasked = 0;
+	for (size_t j = 0; j < nshares; j++)
+	{
+		z_unmasked ^= z[j];
+	}
+
+	assert(z_unmasked == (x_unmasked & y_unmasked));
+#endif
+}
+
+void SecAND64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares])
+{
+	SECAND_SIMD_DISPATCH(nshares, 64, z, x, y)
+	FIXED_DISPATCH(nshares, SecAND64, (z, x, y));
+
+	uint64_t R[SECAND_NRAND(nshares) + 1];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND64);
+
+	for (size_t i = 0; i < SECAND_NRAND(nshares); i++)
+	{
+		R[i] = random_uint64();
+	}
+
+	SecAND64_rand(nshares, z, x, y, R);
+
+	PROFILE_RAND_GADGET_END();
+}
+
+void SecAND64_batch(size_t nshares, size_t K, uint64_t z[K][nshares], const uint64_t x[K][nshares], const uint64_t y[K][nshares])
+{
+	SECAND_SIMD_BATCH_DISPATCH(nshares, 64, K, z, x, y)
+	FIXED_DISPATCH(nshares, SecAND64_batch, (K, z, x, y));
+
+	size_t nrand = SECAND_NRAND(nshares);
+	size_t chunk = (nrand == 0 || nrand > SECAND_BATCH_WORDS) ? 1 : SECAND_BATCH_WORDS / nrand;
+	uint64_t R[chunk * nrand + 1];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND64);
+
+	for (size_t k0 = 0; k0 < K; k0 += chunk)
+	{
+		size_t kn = (K - k0 < chunk) ? (K - k0) : chunk;
+
+		random_uint64_n(R, kn * nrand);
+		for (size_t k = 0; k < kn; k++)
+		{
+			SecAND64_rand(nshares, z[k0 + k], x[k0 + k], y[k0 + k], &R[k * nrand]);
+		}
+	}
+
+	PROFILE_RAND_GADGET_END();
+}
+
+#ifdef LANE_VECTOR
+// [http://www.crypto-uni.lu/jscoron/publications/secconvorder.pdf, Algorithm 1] on vector lanes, with the random lanes in R
+static void SecAND_lane_rand(size_t nshares, lane_t z[nshares], const lane_t x[nshares], const lane_t y[nshares], const lane_t *R)
+{
+	lane_t r[nshares][nshares];
+
+	LANE_APPLY(SECAND_LOWRAND_DISPATCH, nshares, LANE_BITS, z, x, y, R)
+
+#ifdef DEBUG
+	lane_t x_unmasked = {0};
+	lane_t y_unmasked = {0};
+	lane_t z_unmasked = {0};
 
 	for (size_t j = 0; j < nshares; j++)
 	{
 		x_unmasked ^= x[j];
 		y_unmasked ^= y[j];
+	}
+#endif
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		for (size_t j = (i + 1); j < nshares; j++)
+		{
+			r[i][j] = *R++;
+			r[j][i] = r[i][j] ^ (x[i] & y[j]);
+			r[j][i] = r[j][i] ^ (x[j] & y[i]);
+		}
+	}
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		z[i] = x[i] & y[i];
+		for (size_t j = 0; j < nshares; j++)
+		{
+			if (i != j)
+			{
+				z[i] ^= r[i][j];
+			}
+		}
+	}
+
+#ifdef DEBUG
+	for (size_t j = 0; j < nshares; j++)
+	{
 		z_unmasked ^= z[j];
 	}
 
-	assert(z_unmasked == (x_unmasked & y_unmasked));
+	for (size_t w = 0; w < LANE_WORDS; w++)
+	{
+		assert(lane_word(&z_unmasked, w) == (lane_word(&x_unmasked, w) & lane_word(&y_unmasked, w)));
+	}
+#endif
+}
+
+void SecANDL(size_t nshares, lane_t z[nshares], const lane_t x[nshares], const lane_t y[nshares])
+{
+	LANE_APPLY(FIXED_DISPATCH, nshares, SecANDL, (z, x, y));
+
+	lane_t R[SECAND_NRAND(nshares) + 1];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND_LANE);
+
+	random_lane_n(R, SECAND_NRAND(nshares));
+
+	SecAND_lane_rand(nshares, z, x, y, R);
+
+	PROFILE_RAND_GADGET_END();
+}
+
+void SecANDL_batch(size_t nshares, size_t K, lane_t z[K][nshares], const lane_t x[K][nshares], const lane_t y[K][nshares])
+{
+	LANE_APPLY(FIXED_DISPATCH, nshares, SecANDL_batch, (K, z, x, y));
+
+	size_t nrand = SECAND_NRAND(nshares);
+	size_t chunk = (nrand == 0 || nrand > SECAND_BATCH_WORDS) ? 1 : SECAND_BATCH_WORDS / nrand;
+	lane_t R[chunk * nrand + 1];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND_LANE);
+
+	for (size_t k0 = 0; k0 < K; k0 += chunk)
+	{
+		size_t kn = (K - k0 < chunk) ? (K - k0) : chunk;
+
+		random_lane_n(R, kn * nrand);
+		for (size_t k = 0; k < kn; k++)
+		{
+			SecAND_lane_rand(nshares, z[k0 + k], x[k0 + k], y[k0 + k], &R[k * nrand]);
+		}
+	}
+
+	PROFILE_RAND_GADGET_END();
+}
+#endif
+
+// number of 32-bit random words drawn per call
+size_t SecAND32_rand_words(size_t nshares)
+{
+	return SECAND_NRAND(nshares);
+}
+
+size_t SecAND64_rand_words(size_t nshares)
+{
+	return 2 * SECAND_NRAND(nshares);
+}
+
+#ifdef LANE_VECTOR
+size_t SecANDL_rand_words(size_t nshares)
+{
+	return LANE_WORDS * SECAND_NRAND(nshares);
+}
 #endif
-}
\ No newline at end of file
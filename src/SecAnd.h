@@ -32,11 +32,306 @@
 
 #ifdef DEBUG
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #endif
 
+#include "randombytes.h"
+#include "FixedShares.h"
+#include "Lane.h"
+
 void SecAND32(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares]);
 void SecAND64(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares]);
 
+// K independent SecANDs with contiguous operands, randomness drawn in bulk: same words, in the same order, as K calls
+void SecAND32_batch(size_t nshares, size_t K, uint32_t z[K][nshares], const uint32_t x[K][nshares], const uint32_t y[K][nshares]);
+void SecAND64_batch(size_t nshares, size_t K, uint64_t z[K][nshares], const uint64_t x[K][nshares], const uint64_t y[K][nshares]);
+
+#ifndef SECAND_BATCH_WORDS
+    #define SECAND_BATCH_WORDS 512 // random words (of the gadget width) buffered per bulk request
+#endif
+
+/*
+* SECAND_LOWRAND: multiplication gadgets that need less randomness than ISW, used by every SecAND caller.
+* They are (nshares - 1)-probing secure but not SNI, so the compositions built on them (SecAdd, A2B, the equality tests)
+* no longer inherit the composable ISW guarantees: randomness is traded for security margin.
+*   nshares = 3  : [Belaid et al., Randomness Complexity of Private Circuits for Multiplication, EUROCRYPT 2016] 2 words instead of 3
+*   nshares >= 4 : rotation-based parallel multiplication [Barthe et al., Parallel Implementations of Masking Schemes and
+*                  the Bounded Moment Leakage Model, EUROCRYPT 2017], nshares words per two share distances, about nshares^2/4
+* With 2 shares the gadget stays ISW, and the simd kernels (which implement ISW) are not used.
+*/
+#ifdef SECAND_LOWRAND
+    #define SECAND_VARIANT "LOWRAND"
+    #define SECAND_NRAND(n) ((n) < 3 ? (n) * ((n) - 1) / 2 : (n) == 3 ? 2 : (n) * (((n) / 2 + 1) / 2))
+#else
+    #define SECAND_VARIANT "ISW"
+    #define SECAND_NRAND(n) ((n) * ((n) - 1) / 2)
+#endif
+
+// x86-64 host: share-parallel AVX2/AVX-512 SecAND for high orders (SecAnd_simd.c)
+#if defined(__x86_64__) && !defined(SECAND_NO_SIMD) && !defined(SECAND_LOWRAND)
+
+    #define SECAND_SIMD
+
+    #ifndef SECAND_SIMD_MIN
+        #define SECAND_SIMD_MIN 8 // smallest nshares that uses the simd kernels, below this the unrolled scalar gadgets are faster
+    #endif
+
+    void SecAND32_simd(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares]);
+    void SecAND64_simd(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares]);
+    void SecAND32_simd_batch(size_t nshares, size_t K, uint32_t z[K][nshares], const uint32_t x[K][nshares], const uint32_t y[K][nshares]);
+    void SecAND64_simd_batch(size_t nshares, size_t K, uint64_t z[K][nshares], const uint64_t x[K][nshares], const uint64_t y[K][nshares]);
+
+    static inline int SecAND_simd_available(void)
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+
+    #define SECAND_SIMD_CALL(n, f, args)                            \
+        if ((n) >= SECAND_SIMD_MIN && SecAND_simd_available())      \
+        {                                                           \
+            f args;                                                 \
+            return;                                                 \
+        }
+
+    // kernels for 32- and 64-bit words only: vector lanes (Lane.h) are already parallel across coefficients
+    #define SECAND_SIMD_DISPATCH(n, W, z, x, y) SECAND_SIMD_DISPATCH_##W(n, z, x, y)
+    #define SECAND_SIMD_BATCH_DISPATCH(n, W, K, z, x, y) SECAND_SIMD_BATCH_DISPATCH_##W(n, K, z, x, y)
+
+    #define SECAND_SIMD_DISPATCH_32(n, z, x, y) SECAND_SIMD_CALL(n, SecAND32_simd, (n, z, x, y))
+    #define SECAND_SIMD_DISPATCH_64(n, z, x, y) SECAND_SIMD_CALL(n, SecAND64_simd, (n, z, x, y))
+    #define SECAND_SIMD_BATCH_DISPATCH_32(n, K, z, x, y) SECAND_SIMD_CALL(n, SecAND32_simd_batch, (n, K, z, x, y))
+    #define SECAND_SIMD_BATCH_DISPATCH_64(n, K, z, x, y) SECAND_SIMD_CALL(n, SecAND64_simd_batch, (n, K, z, x, y))
+
+    #define SECAND_SIMD_DISPATCH_128(n, z, x, y)
+    #define SECAND_SIMD_DISPATCH_256(n, z, x, y)
+    #define SECAND_SIMD_DISPATCH_512(n, z, x, y)
+    #define SECAND_SIMD_BATCH_DISPATCH_128(n, K, z, x, y)
+    #define SECAND_SIMD_BATCH_DISPATCH_256(n, K, z, x, y)
+    #define SECAND_SIMD_BATCH_DISPATCH_512(n, K, z, x, y)
+#else
+    #define SECAND_SIMD_DISPATCH(n, W, z, x, y)
+    #define SECAND_SIMD_BATCH_DISPATCH(n, W, K, z, x, y)
+#endif
+
+// unmasks the operands a, b and the result c of an n-share AND gadget of width W and checks c = a & b
+#ifdef DEBUG
+    #define SECAND_CHECK(n, W, c, a, b)                                                         \
+        do                                                                                      \
+        {                                                                                       \
+            uint##W##_t au_ = {0}, bu_ = {0}, cu_ = {0}, du_;                                   \
+                                                                                                \
+            for (size_t i_ = 0; i_ < (n); i_++)                                                 \
+            {                                                                                   \
+                au_ ^= (a)[i_];                                                                 \
+                bu_ ^= (b)[i_];                                                                 \
+                cu_ ^= (c)[i_];                                                                 \
+            }                                                                                   \
+                                                                                                \
+            du_ = cu_ ^ (au_ & bu_);                                                            \
+            assert(memcmp(&du_, &(uint##W##_t){0}, sizeof(du_)) == 0);                          \
+        } while (0)
+#else
+    #define SECAND_CHECK(n, W, c, a, b) do {} while (0)
+#endif
+
+#ifdef SECAND_LOWRAND
+
+/*
+* c_i = a_i b_i, then for each round of two share distances d, d + 1 with n fresh words R (share indices mod n):
+* c_i ^= R_i ^ a_i b_{i+d} ^ a_{i+d} b_i ^ R_{i+1} ^ a_i b_{i+d+1} ^ a_{i+d+1} b_i, accumulated in this order.
+* A distance of n/2 only adds a_i b_{i+n/2}: a_{i+n/2} b_i is already the term of share i + n/2.
+* For 3 shares, two words suffice: R_0 and R_1 each mask one share and are cancelled in the third.
+*/
+#define SECAND_LOWRAND_KERNEL(W)                                                                                            \
+    static inline void SecAND##W##_lowrand(size_t n, uint##W##_t z[n], const uint##W##_t x[n], const uint##W##_t y[n],      \
+                                           const uint##W##_t *R)                                                            \
+    {                                                                                                                       \
+        uint##W##_t a[n], b[n], c[n];                                                                                       \
+                                                                                                                            \
+        FIXED_UNROLL                                                                                                        \
+        for (size_t i = 0; i < n; i++)                                                                                      \
+        {                                                                                                                   \
+            a[i] = x[i];                                                                                                    \
+            b[i] = y[i];                                                                                                    \
+        }                                                                                                                   \
+                                                                                                                            \
+        if (n == 3)                                                                                                         \
+        {                                                                                                                   \
+            c[0] = ((R[0] ^ (a[0] & b[0])) ^ (a[0] & b[2])) ^ (a[2] & b[0]);                                                \
+            c[1] = ((R[1] ^ (a[1] & b[1])) ^ (a[0] & b[1])) ^ (a[1] & b[0]);                                                \
+            c[2] = (((R[0] ^ R[1]) ^ (a[2] & b[2])) ^ (a[1] & b[2])) ^ (a[2] & b[1]);                                       \
+        }                                                                                                                   \
+        else                                                                                                                \
+        {                                                                                                                   \
+            FIXED_UNROLL                                                                                                    \
+            for (size_t i = 0; i < n; i++)                                                                                  \
+            {                                                                                                               \
+                c[i] = a[i] & b[i];                                                                                         \
+            }                                                                                                               \
+                                                                                                                            \
+            FIXED_UNROLL                                                                                                    \
+            for (size_t d = 1; d <= n / 2; d += 2)                                                                          \
+            {                                                                                                               \
+                FIXED_UNROLL                                                                                                \
+                for (size_t i = 0; i < n; i++)                                                                              \
+                {                                                                                                           \
+                    size_t j = (i + d) % n;                                                                                 \
+                    size_t k = (i + d + 1) % n;                                                                             \
+                                                                                                                            \
+                    c[i] ^= R[i];                                                                                           \
+                    c[i] ^= a[i] & b[j];                                                                                    \
+                    if (2 * d != n)                                                                                         \
+                    {                                                                                                       \
+                        c[i] ^= a[j] & b[i];                                                                                \
+                    }                                                                                                       \
+                    c[i] ^= R[(i + 1) % n];                                                                                 \
+                    if (d + 1 <= n / 2)                                                                                     \
+                    {                                                                                                       \
+                        c[i] ^= a[i] & b[k];                                                                                \
+                        if (2 * (d + 1) != n)                                                                               \
+                        {                                                                                                   \
+                            c[i] ^= a[k] & b[i];                                                                            \
+                        }                                                                                                   \
+                    }                                                                                                       \
+                }                                                                                                           \
+                R += n;                                                                                                     \
+            }                                                                                                               \
+        }                                                                                                                   \
+                                                                                                                            \
+        SECAND_CHECK(n, W, c, a, b);                                                                                        \
+                                                                                                                            \
+        FIXED_UNROLL                                                                                                        \
+        for (size_t i = 0; i < n; i++)                                                                                      \
+        {                                                                                                                   \
+            z[i] = c[i];                                                                                                    \
+        }                                                                                                                   \
+    }
+
+SECAND_LOWRAND_KERNEL(32)
+SECAND_LOWRAND_KERNEL(64)
+#ifdef LANE_VECTOR
+LANE_APPLY(SECAND_LOWRAND_KERNEL, LANE_BITS)
+#endif
+
+    #define SECAND_LOWRAND_DISPATCH(n, W, z, x, y, R)               \
+        if ((n) >= 3)                                               \
+        {                                                           \
+            SecAND##W##_lowrand(n, z, x, y, R);                     \
+            return;                                                 \
+        }
+#else
+    #define SECAND_LOWRAND_DISPATCH(n, W, z, x, y, R)
+#endif
+
+/*
+* SecAND for a fixed number of shares: same randomness, in the same order, as the generic version.
+* The shares are loaded first, so z may alias x or y, and the cross terms are accumulated directly.
+* The kernel takes the SECAND_NRAND(N) random words in R, the batched variant fills R for many ANDs at once.
+* Both variants go through the kernel, which checks the result under DEBUG like the generic version.
+* A chunk holds at least one gadget, even when SECAND_BATCH_WORDS is smaller than SECAND_NRAND(N).
+*/
+#define SECAND_FIXED(N, W)                                                                                  \
+    static inline void SecAND##W##_rand_##N(uint##W##_t z[N], const uint##W##_t x[N], const uint##W##_t y[N], \
+                                            const uint##W##_t R[SECAND_NRAND(N)])                           \
+    {                                                                                                       \
+        uint##W##_t a[N], b[N], c[N];                                                                       \
+        size_t k = 0;                                                                                       \
+                                                                                                            \
+        SECAND_LOWRAND_DISPATCH(N, W, z, x, y, R)                                                           \
+                                                                                                            \
+        FIXED_UNROLL                                                                                        \
+        for (size_t i = 0; i < N; i++)                                                                      \
+        {                                                                                                   \
+            a[i] = x[i];                                                                                    \
+            b[i] = y[i];                                                                                    \
+            c[i] = a[i] & b[i];                                                                             \
+        }                                                                                                   \
+                                                                                                            \
+        FIXED_UNROLL                                                                                        \
+        for (size_t i = 0; i < N; i++)                                                                      \
+        {                                                                                                   \
+            FIXED_UNROLL                                                                                    \
+            for (size_t j = i + 1; j < N; j++)                                                              \
+            {                                                                                               \
+                c[i] ^= R[k];                                                                               \
+                c[j] ^= (R[k] ^ (a[i] & b[j])) ^ (a[j] & b[i]);                                             \
+                k++;                                                                                        \
+            }                                                                                               \
+        }                                                                                                   \
+                                                                                                            \
+        SECAND_CHECK(N, W, c, a, b);                                                                        \
+                                                                                                            \
+        FIXED_UNROLL                                                                                        \
+        for (size_t i = 0; i < N; i++)                                                                      \
+        {                                                                                                   \
+            z[i] = c[i];                                                                                    \
+        }                                                                                                   \
+    }                                                                                                       \
+                                                                                                            \
+    static inline void SecAND##W##_##N(uint##W##_t z[N], const uint##W##_t x[N], const uint##W##_t y[N])    \
+    {                                                                                                       \
+        uint##W##_t R[SECAND_NRAND(N)];                                                                     \
+                                                                                                            \
+        SECAND_SIMD_DISPATCH(N, W, z, x, y)                                                                 \
+                                                                                                            \
+        PROFILE_RAND_GADGET(RNG_GADGET_SECAND##W);                                                          \
+                                                                                                            \
+        FIXED_UNROLL                                                                                        \
+        for (size_t k = 0; k < SECAND_NRAND(N); k++)                                                        \
+        {                                                                                                   \
+            R[k] = random_uint##W();                                                                        \
+        }                                                                                                   \
+                                                                                                            \
+        SecAND##W##_rand_##N(z, x, y, R);                                                                   \
+                                                                                                            \
+        PROFILE_RAND_GADGET_END();                                                                          \
+    }                                                                                                       \
+                                                                                                            \
+    static inline void SecAND##W##_batch_##N(size_t K, uint##W##_t z[K][N], const uint##W##_t x[K][N],      \
+                                             const uint##W##_t y[K][N])                                     \
+    {                                                                                                       \
+        enum { NRAND = SECAND_NRAND(N) };                                                                   \
+        enum { CHUNK = (NRAND > SECAND_BATCH_WORDS) ? 1 : SECAND_BATCH_WORDS / NRAND };                     \
+        uint##W##_t R[CHUNK * NRAND];                                                                       \
+                                                                                                            \
+        SECAND_SIMD_BATCH_DISPATCH(N, W, K, z, x, y)                                                        \
+                                                                                                            \
+        PROFILE_RAND_GADGET(RNG_GADGET_SECAND##W);                                                          \
+                                                                                                            \
+        for (size_t k0 = 0; k0 < K; k0 += CHUNK)                                                            \
+        {                                                                                                   \
+            size_t kn = (K - k0 < CHUNK) ? (K - k0) : CHUNK;                                                \
+                                                                                                            \
+            random_uint##W##_n(R, kn * NRAND);                                                              \
+            for (size_t k = 0; k < kn; k++)                                                                 \
+            {                                                                                               \
+                SecAND##W##_rand_##N(z[k0 + k], x[k0 + k], y[k0 + k], &R[k * NRAND]);                       \
+            }                                                                                               \
+        }                                                                                                   \
+                                                                                                            \
+        PROFILE_RAND_GADGET_END();                                                                          \
+    }
+
+#define SECAND32_FIXED(N) SECAND_FIXED(N, 32)
+#define SECAND64_FIXED(N) SECAND_FIXED(N, 64)
+
+FIXED_INSTANTIATE(SECAND32_FIXED)
+FIXED_INSTANTIATE(SECAND64_FIXED)
+
+size_t SecAND32_rand_words(size_t nshares);
+size_t SecAND64_rand_words(size_t nshares);
+
+// vector lanes: the same gadgets at width LANE_BITS, SecAND<LANE_BITS> for the bitsliced pipeline
+#ifdef LANE_VECTOR
+    #define SECANDL_FIXED(N) LANE_APPLY(SECAND_FIXED, N, LANE_BITS)
+
+    FIXED_INSTANTIATE(SECANDL_FIXED)
+
+    void SecANDL(size_t nshares, lane_t z[nshares], const lane_t x[nshares], const lane_t y[nshares]);
+    void SecANDL_batch(size_t nshares, size_t K, lane_t z[K][nshares], const lane_t x[K][nshares], const lane_t y[K][nshares]);
+    size_t SecANDL_rand_words(size_t nshares);
+#endif
+
 
 #endif // SECAND_H
\ No newline at end of file
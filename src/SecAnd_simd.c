@@ -0,0 +1,421 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SecAnd.h"
+#include "randombytes.h"
+
+#ifdef SECAND_SIMD
+
+#include <immintrin.h>
+
+/*
+* Share-parallel ISW: row i handles all pairs (i, j > i) at once.
+* Lane j computes r_ji = (r_ij ^ (x_i & y_j)) ^ (x_j & y_i) with the same operation order as SecAND32/64,
+* and XORs it into z_j. All randomness is drawn up front, in the order of the scalar version.
+*/
+
+__attribute__((target("avx2")))
+static inline __m256i tail_mask32_avx2(size_t len)
+{
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)len), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i tail_mask64_avx2(size_t len)
+{
+	return _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)len), _mm256_setr_epi64x(0, 1, 2, 3));
+}
+
+__attribute__((target("avx2")))
+static uint32_t hxor32_avx2(__m256i v)
+{
+	__m128i t = _mm_xor_si128(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	t = _mm_xor_si128(t, _mm_shuffle_epi32(t, 0x4e));
+	t = _mm_xor_si128(t, _mm_shuffle_epi32(t, 0xb1));
+	return (uint32_t)_mm_cvtsi128_si32(t);
+}
+
+__attribute__((target("avx2")))
+static uint64_t hxor64_avx2(__m256i v)
+{
+	__m128i t = _mm_xor_si128(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	t = _mm_xor_si128(t, _mm_shuffle_epi32(t, 0x4e));
+	return (uint64_t)_mm_cvtsi128_si64(t);
+}
+
+__attribute__((target("avx2")))
+static void SecAND32_avx2(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares], const uint32_t *R)
+{
+	uint32_t acc[nshares];
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		acc[i] = x[i] & y[i];
+	}
+
+	for (size_t i = 0; i < nshares - 1; i++)
+	{
+		size_t len = nshares - 1 - i;
+		__m256i xi = _mm256_set1_epi32((int)x[i]);
+		__m256i yi = _mm256_set1_epi32((int)y[i]);
+		__m256i rsum = _mm256_setzero_si256();
+
+		for (size_t k = 0; k < len; k += 8)
+		{
+			__m256i m = tail_mask32_avx2(len - k);
+			__m256i r = _mm256_maskload_epi32((const int *)&R[k], m);
+			__m256i xj = _mm256_maskload_epi32((const int *)&x[i + 1 + k], m);
+			__m256i yj = _mm256_maskload_epi32((const int *)&y[i + 1 + k], m);
+			__m256i zj = _mm256_maskload_epi32((const int *)&acc[i + 1 + k], m);
+
+			__m256i t = _mm256_xor_si256(r, _mm256_and_si256(xi, yj));
+			t = _mm256_xor_si256(t, _mm256_and_si256(xj, yi));
+
+			_mm256_maskstore_epi32((int *)&acc[i + 1 + k], m, _mm256_xor_si256(zj, t));
+			rsum = _mm256_xor_si256(rsum, r);
+		}
+
+		acc[i] ^= hxor32_avx2(rsum);
+		R += len;
+	}
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		z[i] = acc[i];
+	}
+}
+
+__attribute__((target("avx2")))
+static void SecAND64_avx2(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares], const uint64_t *R)
+{
+	uint64_t acc[nshares];
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		acc[i] = x[i] & y[i];
+	}
+
+	for (size_t i = 0; i < nshares - 1; i++)
+	{
+		size_t len = nshares - 1 - i;
+		__m256i xi = _mm256_set1_epi64x((long long)x[i]);
+		__m256i yi = _mm256_set1_epi64x((long long)y[i]);
+		__m256i rsum = _mm256_setzero_si256();
+
+		for (size_t k = 0; k < len; k += 4)
+		{
+			__m256i m = tail_mask64_avx2(len - k);
+			__m256i r = _mm256_maskload_epi64((const long long *)&R[k], m);
+			__m256i xj = _mm256_maskload_epi64((const long long *)&x[i + 1 + k], m);
+			__m256i yj = _mm256_maskload_epi64((const long long *)&y[i + 1 + k], m);
+			__m256i zj = _mm256_maskload_epi64((const long long *)&acc[i + 1 + k], m);
+
+			__m256i t = _mm256_xor_si256(r, _mm256_and_si256(xi, yj));
+			t = _mm256_xor_si256(t, _mm256_and_si256(xj, yi));
+
+			_mm256_maskstore_epi64((long long *)&acc[i + 1 + k], m, _mm256_xor_si256(zj, t));
+			rsum = _mm256_xor_si256(rsum, r);
+		}
+
+		acc[i] ^= hxor64_avx2(rsum);
+		R += len;
+	}
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		z[i] = acc[i];
+	}
+}
+
+// VPTERNLOG immediate for a ^ (b & c)
+#define TERNLOG_XOR_AND 0x78
+
+__attribute__((target("avx512f")))
+static void SecAND32_avx512(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares], const uint32_t *R)
+{
+	uint32_t acc[nshares];
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		acc[i] = x[i] & y[i];
+	}
+
+	for (size_t i = 0; i < nshares - 1; i++)
+	{
+		size_t len = nshares - 1 - i;
+		__m512i xi = _mm512_set1_epi32((int)x[i]);
+		__m512i yi = _mm512_set1_epi32((int)y[i]);
+		__m512i rsum = _mm512_setzero_si512();
+
+		for (size_t k = 0; k < len; k += 16)
+		{
+			__mmask16 m = (len - k >= 16) ? 0xffff : (__mmask16)((1u << (len - k)) - 1);
+			__m512i r = _mm512_maskz_loadu_epi32(m, &R[k]);
+			__m512i xj = _mm512_maskz_loadu_epi32(m, &x[i + 1 + k]);
+			__m512i yj = _mm512_maskz_loadu_epi32(m, &y[i + 1 + k]);
+			__m512i zj = _mm512_maskz_loadu_epi32(m, &acc[i + 1 + k]);
+
+			__m512i t = _mm512_ternarylogic_epi32(r, xi, yj, TERNLOG_XOR_AND);
+			t = _mm512_ternarylogic_epi32(t, xj, yi, TERNLOG_XOR_AND);
+
+			_mm512_mask_storeu_epi32(&acc[i + 1 + k], m, _mm512_xor_si512(zj, t));
+			rsum = _mm512_xor_si512(rsum, r);
+		}
+
+		__m256i h = _mm256_xor_si256(_mm512_castsi512_si256(rsum), _mm512_extracti64x4_epi64(rsum, 1));
+		__m128i t = _mm_xor_si128(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+		t = _mm_xor_si128(t, _mm_shuffle_epi32(t, 0x4e));
+		t = _mm_xor_si128(t, _mm_shuffle_epi32(t, 0xb1));
+		acc[i] ^= (uint32_t)_mm_cvtsi128_si32(t);
+		R += len;
+	}
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		z[i] = acc[i];
+	}
+}
+
+__attribute__((target("avx512f")))
+static void SecAND64_avx512(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares], const uint64_t *R)
+{
+	uint64_t acc[nshares];
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		acc[i] = x[i] & y[i];
+	}
+
+	for (size_t i = 0; i < nshares - 1; i++)
+	{
+		size_t len = nshares - 1 - i;
+		__m512i xi = _mm512_set1_epi64((long long)x[i]);
+		__m512i yi = _mm512_set1_epi64((long long)y[i]);
+		__m512i rsum = _mm512_setzero_si512();
+
+		for (size_t k = 0; k < len; k += 8)
+		{
+			__mmask8 m = (len - k >= 8) ? 0xff : (__mmask8)((1u << (len - k)) - 1);
+			__m512i r = _mm512_maskz_loadu_epi64(m, &R[k]);
+			__m512i xj = _mm512_maskz_loadu_epi64(m, &x[i + 1 + k]);
+			__m512i yj = _mm512_maskz_loadu_epi64(m, &y[i + 1 + k]);
+			__m512i zj = _mm512_maskz_loadu_epi64(m, &acc[i + 1 + k]);
+
+			__m512i t = _mm512_ternarylogic_epi64(r, xi, yj, TERNLOG_XOR_AND);
+			t = _mm512_ternarylogic_epi64(t, xj, yi, TERNLOG_XOR_AND);
+
+			_mm512_mask_storeu_epi64(&acc[i + 1 + k], m, _mm512_xor_si512(zj, t));
+			rsum = _mm512_xor_si512(rsum, r);
+		}
+
+		__m256i h = _mm256_xor_si256(_mm512_castsi512_si256(rsum), _mm512_extracti64x4_epi64(rsum, 1));
+		__m128i t = _mm_xor_si128(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+		t = _mm_xor_si128(t, _mm_shuffle_epi32(t, 0x4e));
+		acc[i] ^= (uint64_t)_mm_cvtsi128_si64(t);
+		R += len;
+	}
+
+	for (size_t i = 0; i < nshares; i++)
+	{
+		z[i] = acc[i];
+	}
+}
+
+/*
+* All shares in one register: lane j of row i reads R_ij from a row pointer that is offset by i + 1,
+* so x, y and z stay in registers for the whole gadget. R is preceded by nshares words of padding,
+* which are never read because those lanes are masked off.
+*/
+__attribute__((target("avx512f")))
+static void SecAND32_avx512_reg(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares], const uint32_t *R)
+{
+	__mmask16 all = (__mmask16)((1u << nshares) - 1);
+	__m512i X = _mm512_maskz_loadu_epi32(all, x);
+	__m512i Y = _mm512_maskz_loadu_epi32(all, y);
+	__m512i Z = _mm512_and_si512(X, Y);
+
+	for (size_t i = 0; i < nshares - 1; i++)
+	{
+		__mmask16 m = all & (__mmask16)(0xffffu << (i + 1));
+		__m512i r = _mm512_maskz_loadu_epi32(m, R - (i + 1));
+
+		__m512i t = _mm512_ternarylogic_epi32(r, _mm512_set1_epi32((int)x[i]), Y, TERNLOG_XOR_AND);
+		t = _mm512_ternarylogic_epi32(t, X, _mm512_set1_epi32((int)y[i]), TERNLOG_XOR_AND);
+		Z = _mm512_mask_xor_epi32(Z, m, Z, t);
+
+		__m256i h = _mm256_xor_si256(_mm512_castsi512_si256(r), _mm512_extracti64x4_epi64(r, 1));
+		__m128i s = _mm_xor_si128(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+		s = _mm_xor_si128(s, _mm_shuffle_epi32(s, 0x4e));
+		s = _mm_xor_si128(s, _mm_shuffle_epi32(s, 0xb1));
+		Z = _mm512_mask_xor_epi32(Z, (__mmask16)(1u << i), Z, _mm512_broadcastd_epi32(s));
+
+		R += nshares - 1 - i;
+	}
+
+	_mm512_mask_storeu_epi32(z, all, Z);
+}
+
+__attribute__((target("avx512f")))
+static void SecAND64_avx512_reg(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares], const uint64_t *R)
+{
+	__mmask8 all = (__mmask8)((1u << nshares) - 1);
+	__m512i X = _mm512_maskz_loadu_epi64(all, x);
+	__m512i Y = _mm512_maskz_loadu_epi64(all, y);
+	__m512i Z = _mm512_and_si512(X, Y);
+
+	for (size_t i = 0; i < nshares - 1; i++)
+	{
+		__mmask8 m = all & (__mmask8)(0xffu << (i + 1));
+		__m512i r = _mm512_maskz_loadu_epi64(m, R - (i + 1));
+
+		__m512i t = _mm512_ternarylogic_epi64(r, _mm512_set1_epi64((long long)x[i]), Y, TERNLOG_XOR_AND);
+		t = _mm512_ternarylogic_epi64(t, X, _mm512_set1_epi64((long long)y[i]), TERNLOG_XOR_AND);
+		Z = _mm512_mask_xor_epi64(Z, m, Z, t);
+
+		__m256i h = _mm256_xor_si256(_mm512_castsi512_si256(r), _mm512_extracti64x4_epi64(r, 1));
+		__m128i s = _mm_xor_si128(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+		s = _mm_xor_si128(s, _mm_shuffle_epi32(s, 0x4e));
+		Z = _mm512_mask_xor_epi64(Z, (__mmask8)(1u << i), Z, _mm512_broadcastq_epi64(s));
+
+		R += nshares - 1 - i;
+	}
+
+	_mm512_mask_storeu_epi64(z, all, Z);
+}
+
+static void SecAND32_simd_rand(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares], const uint32_t *R)
+{
+	if (__builtin_cpu_supports("avx512f") && nshares <= 16)
+	{
+		SecAND32_avx512_reg(nshares, z, x, y, R);
+	}
+	else if (__builtin_cpu_supports("avx512f"))
+	{
+		SecAND32_avx512(nshares, z, x, y, R);
+	}
+	else
+	{
+		SecAND32_avx2(nshares, z, x, y, R);
+	}
+}
+
+void SecAND32_simd(size_t nshares, uint32_t z[nshares], const uint32_t x[nshares], const uint32_t y[nshares])
+{
+	uint32_t Rpad[nshares + nshares * (nshares - 1) / 2];
+	uint32_t *R = &Rpad[nshares];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND32);
+
+	for (size_t i = 0; i < nshares * (nshares - 1) / 2; i++)
+	{
+		R[i] = random_uint32();
+	}
+
+	SecAND32_simd_rand(nshares, z, x, y, R);
+
+	PROFILE_RAND_GADGET_END();
+}
+
+// consecutive gadgets share one buffer, the words of the previous gadget serve as the padding of the next
+void SecAND32_simd_batch(size_t nshares, size_t K, uint32_t z[K][nshares], const uint32_t x[K][nshares], const uint32_t y[K][nshares])
+{
+	size_t pairs = nshares * (nshares - 1) / 2;
+	size_t chunk = (pairs > SECAND_BATCH_WORDS) ? 1 : SECAND_BATCH_WORDS / pairs;
+	uint32_t Rpad[nshares + chunk * pairs];
+	uint32_t *R = &Rpad[nshares];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND32);
+
+	for (size_t k0 = 0; k0 < K; k0 += chunk)
+	{
+		size_t kn = (K - k0 < chunk) ? (K - k0) : chunk;
+
+		random_uint32_n(R, kn * pairs);
+		for (size_t k = 0; k < kn; k++)
+		{
+			SecAND32_simd_rand(nshares, z[k0 + k], x[k0 + k], y[k0 + k], &R[k * pairs]);
+		}
+	}
+
+	PROFILE_RAND_GADGET_END();
+}
+
+static void SecAND64_simd_rand(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares], const uint64_t *R)
+{
+	if (__builtin_cpu_supports("avx512f") && nshares <= 8)
+	{
+		SecAND64_avx512_reg(nshares, z, x, y, R);
+	}
+	else if (__builtin_cpu_supports("avx512f"))
+	{
+		SecAND64_avx512(nshares, z, x, y, R);
+	}
+	else
+	{
+		SecAND64_avx2(nshares, z, x, y, R);
+	}
+}
+
+void SecAND64_simd(size_t nshares, uint64_t z[nshares], const uint64_t x[nshares], const uint64_t y[nshares])
+{
+	uint64_t Rpad[nshares + nshares * (nshares - 1) / 2];
+	uint64_t *R = &Rpad[nshares];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND64);
+
+	for (size_t i = 0; i < nshares * (nshares - 1) / 2; i++)
+	{
+		R[i] = random_uint64();
+	}
+
+	SecAND64_simd_rand(nshares, z, x, y, R);
+
+	PROFILE_RAND_GADGET_END();
+}
+
+// consecutive gadgets share one buffer, the words of the previous gadget serve as the padding of the next
+void SecAND64_simd_batch(size_t nshares, size_t K, uint64_t z[K][nshares], const uint64_t x[K][nshares], const uint64_t y[K][nshares])
+{
+	size_t pairs = nshares * (nshares - 1) / 2;
+	size_t chunk = (pairs > SECAND_BATCH_WORDS) ? 1 : SECAND_BATCH_WORDS / pairs;
+	uint64_t Rpad[nshares + chunk * pairs];
+	uint64_t *R = &Rpad[nshares];
+
+	PROFILE_RAND_GADGET(RNG_GADGET_SECAND64);
+
+	for (size_t k0 = 0; k0 < K; k0 += chunk)
+	{
+		size_t kn = (K - k0 < chunk) ? (K - k0) : chunk;
+
+		random_uint64_n(R, kn * pairs);
+		for (size_t k = 0; k < kn; k++)
+		{
+			SecAND64_simd_rand(nshares, z[k0 + k], x[k0 + k], y[k0 + k], &R[k * pairs]);
+		}
+	}
+
+	PROFILE_RAND_GADGET_END();
+}
+
+#endif // SECAND_SIMD
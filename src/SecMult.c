@@ -26,6 +26,17 @@
 #include "randombytes.h"
 #include "SecMult.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SECMULT_X86
+#endif
+
+// floor(x / q) = (x * floor(2^43 / q)) >> 43, minus at most one, for x < 2^32 and 2^11 < q < 2^16
+#define RANDOMQ_BARRETT_SHIFT 43
+
+// random words drawn in bulk per round of rejection sampling
+#define RANDOMQ_BUF_WORDS 256
+
 // SPOG19
 void secMult(uint32_t nshares, uint32_t q, uint32_t out[nshares], uint32_t A[nshares], uint32_t B[nshares])
 {
@@ -36,10 +47,7 @@ void secMult(uint32_t nshares, uint32_t q, uint32_t out[nshares], uint32_t A[nsh
 	uint32_t Ridx;
 	uint32_t r;
 
-	for(uint32_t i = 0; i<iterations; i+=2)
-	{
-		randomq(&R[i], q);
-	}
+	randomq_batch(iterations, R, q);
 
 	for(uint32_t i=0; i<nshares; i++)
 	{
@@ -87,19 +95,196 @@ uint32_t uncompress(uint32_t x, uint32_t compressto, uint32_t q)
 	return out;
 }
 
-void randomq(uint32_t out[2], uint32_t q)
+// constant-time x - q if x >= q, for x < 2q
+static inline uint32_t csubq(uint32_t x, uint32_t q)
+{
+	uint32_t mask = ((x - q) >> 31) - 1;
+	return x - (q & mask);
+}
+
+// split r < c*q^2 into the uniform pair (r mod q, (r / q) mod q)
+static inline void randomq_split(uint32_t out[2], uint32_t r, uint32_t q, uint64_t m)
+{
+	uint32_t t = (uint32_t)(((uint64_t)r * m) >> RANDOMQ_BARRETT_SHIFT);
+	uint32_t lo = r - t * q;
+
+	// correct the quotient together with the remainder
+	t += ((q - 1 - lo) >> 31);
+	lo = csubq(lo, q);
+
+	uint32_t u = (uint32_t)(((uint64_t)t * m) >> RANDOMQ_BARRETT_SHIFT);
+	uint32_t hi = csubq(t - u * q, q);
+
+	out[0] = lo;
+	out[1] = hi;
+}
+
+// keep the words below bound, in order, at the start of buf
+static size_t randomq_compress(uint32_t *buf, size_t len, uint32_t bound)
+{
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		buf[cnt] = buf[i];
+		cnt += (buf[cnt] < bound);
+	}
+
+	return cnt;
+}
+
+#ifdef SECMULT_X86
+
+__attribute__((target("avx2,bmi2")))
+static size_t randomq_compress_avx2(uint32_t *buf, size_t len, uint32_t bound)
+{
+	const __m256i sign = _mm256_set1_epi32((int)0x80000000);
+	const __m256i vbound = _mm256_set1_epi32((int)(bound ^ 0x80000000));
+	size_t cnt = 0;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		__m256i r = _mm256_loadu_si256((const __m256i *)&buf[i]);
+
+		// unsigned r < bound
+		__m256i accept = _mm256_cmpgt_epi32(vbound, _mm256_xor_si256(r, sign));
+		uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(accept));
+
+		// left-pack the accepted lanes: gather their indices with pext
+		uint64_t idx = _pext_u64(0x0706050403020100, _pdep_u64(mask, 0x0101010101010101) * 0xff);
+		__m256i perm = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)idx));
+
+		// cnt <= i: the store never overwrites words that are still to be read
+		_mm256_storeu_si256((__m256i *)&buf[cnt], _mm256_permutevar8x32_epi32(r, perm));
+		cnt += __builtin_popcount(mask);
+	}
+
+	for (; i < len; i++)
+	{
+		buf[cnt] = buf[i];
+		cnt += (buf[cnt] < bound);
+	}
+
+	return cnt;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i barrett_quot_avx2(__m256i x, __m256i m)
+{
+	__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, m), RANDOMQ_BARRETT_SHIFT);
+	__m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), m), RANDOMQ_BARRETT_SHIFT);
+
+	return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+}
+
+__attribute__((target("avx2")))
+static void randomq_split8_avx2(uint32_t out[16], const uint32_t r[8], uint32_t q, uint32_t m)
+{
+	const __m256i vq = _mm256_set1_epi32((int)q);
+	const __m256i vq1 = _mm256_set1_epi32((int)(q - 1));
+	const __m256i vm = _mm256_set1_epi32((int)m);
+
+	__m256i x = _mm256_loadu_si256((const __m256i *)r);
+	__m256i t = barrett_quot_avx2(x, vm);
+	__m256i lo = _mm256_sub_epi32(x, _mm256_mullo_epi32(t, vq));
+	__m256i c = _mm256_cmpgt_epi32(lo, vq1);
+	lo = _mm256_sub_epi32(lo, _mm256_and_si256(c, vq));
+	t = _mm256_sub_epi32(t, c);
+
+	__m256i u = barrett_quot_avx2(t, vm);
+	__m256i hi = _mm256_sub_epi32(t, _mm256_mullo_epi32(u, vq));
+	c = _mm256_cmpgt_epi32(hi, vq1);
+	hi = _mm256_sub_epi32(hi, _mm256_and_si256(c, vq));
+
+	// interleave to lo0 hi0 lo1 hi1 ...
+	__m256i a = _mm256_unpacklo_epi32(lo, hi);
+	__m256i b = _mm256_unpackhi_epi32(lo, hi);
+	_mm256_storeu_si256((__m256i *)&out[0], _mm256_permute2x128_si256(a, b, 0x20));
+	_mm256_storeu_si256((__m256i *)&out[8], _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+// secMult draws once per multiplication, so the cpu is only queried on the first call
+static int randomq_avx2_available(void)
+{
+	static int avx2 = -1;
+
+	if (avx2 < 0)
+	{
+		avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+	}
+
+	return avx2;
+}
+
+#endif // SECMULT_X86
+
+// n uniform values mod q: rejection sampling on bulk random words, then two values per accepted word
+void randomq_batch(size_t n, uint32_t out[n], uint32_t q)
 {
 	#ifdef DEBUG
-	assert(q==3329);
+	assert(q > (1 << 11) && q < (1 << 16));
 	#endif
 
-	uint32_t r;
-	do
+	uint32_t bound = (uint32_t)((((uint64_t)1 << 32) / (q * q)) * (q * q));
+	uint64_t m = ((uint64_t)1 << RANDOMQ_BARRETT_SHIFT) / q;
+	uint32_t buf[RANDOMQ_BUF_WORDS];
+	size_t filled = 0;
+
+#ifdef SECMULT_X86
+	int avx2 = randomq_avx2_available();
+#endif
+
+	PROFILE_RAND_GADGET(RNG_GADGET_RANDOMQ);
+
+	while (filled < n)
 	{
-		r = random_uint32();
-	} while (r > 387 * q * q);
+		size_t len = (n - filled + 1) / 2;
+		size_t cnt;
+		size_t i = 0;
 
-	r = r % (q * q);
-	out[0] = r % q;
-	out[1] = r / q;
+		if (len > RANDOMQ_BUF_WORDS)
+		{
+			len = RANDOMQ_BUF_WORDS;
+		}
+
+		random_uint32_n(buf, len);
+
+#ifdef SECMULT_X86
+		if (avx2)
+		{
+			cnt = randomq_compress_avx2(buf, len, bound);
+
+			for (; i + 8 <= cnt && filled + 16 <= n; i += 8, filled += 16)
+			{
+				randomq_split8_avx2(&out[filled], &buf[i], q, (uint32_t)m);
+			}
+		}
+		else
+#endif
+		{
+			cnt = randomq_compress(buf, len, bound);
+		}
+
+		for (; i < cnt; i++)
+		{
+			uint32_t pair[2];
+
+			randomq_split(pair, buf[i], q, m);
+			out[filled++] = pair[0];
+
+			// odd n: the second value of the last word is dropped
+			if (filled < n)
+			{
+				out[filled++] = pair[1];
+			}
+		}
+	}
+
+	PROFILE_RAND_GADGET_END();
+}
+
+void randomq(uint32_t out[2], uint32_t q)
+{
+	randomq_batch(2, out, q);
 }
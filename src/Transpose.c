@@ -0,0 +1,249 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Transpose.h"
+
+#ifdef TRANSPOSE_SIMD
+    #include <immintrin.h>
+#endif
+
+// swaps the off-diagonal j x j blocks of every 2j x 2j block, for j = 16, 8, 4, 2, 1
+void transpose32(uint32_t a[32])
+{
+    uint32_t m = 0x0000FFFF;
+
+    for (size_t j = 16; j != 0; j >>= 1, m ^= m << j)
+    {
+        for (size_t k = 0; k < 32; k = (k + j + 1) & ~j)
+        {
+            uint32_t t = ((a[k] >> j) ^ a[k + j]) & m;
+
+            a[k] ^= t << j;
+            a[k + j] ^= t;
+        }
+    }
+}
+
+void transpose64(uint64_t a[64])
+{
+    uint64_t m = 0x00000000FFFFFFFF;
+
+    for (size_t j = 32; j != 0; j >>= 1, m ^= m << j)
+    {
+        for (size_t k = 0; k < 64; k = (k + j + 1) & ~j)
+        {
+            uint64_t t = ((a[k] >> j) ^ a[k + j]) & m;
+
+            a[k] ^= t << j;
+            a[k + j] ^= t;
+        }
+    }
+}
+
+#ifdef TRANSPOSE_SIMD
+
+/*
+* Bit nbits-1 of every word is shifted to the sign bit, then each plane is one movemask per vector,
+* from the top plane down, with a shift by one in between.
+*/
+__attribute__((target("avx2")))
+static void bitslice32_avx2(size_t nbits, uint32_t out[nbits], const uint32_t in[32])
+{
+    __m128i shift = _mm_cvtsi32_si128((int)(32 - nbits));
+    __m256i v[4];
+
+    for (size_t q = 0; q < 4; q++)
+    {
+        v[q] = _mm256_sll_epi32(_mm256_loadu_si256((const __m256i *)&in[8 * q]), shift);
+    }
+
+    for (size_t k = nbits; k-- > 0;)
+    {
+        uint32_t word = 0;
+
+        for (size_t q = 0; q < 4; q++)
+        {
+            word |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(v[q])) << (8 * q);
+            v[q] = _mm256_slli_epi32(v[q], 1);
+        }
+
+        out[k] = word;
+    }
+}
+
+static void bitslice32_sse2(size_t nbits, uint32_t out[nbits], const uint32_t in[32])
+{
+    __m128i shift = _mm_cvtsi32_si128((int)(32 - nbits));
+    __m128i v[8];
+
+    for (size_t q = 0; q < 8; q++)
+    {
+        v[q] = _mm_sll_epi32(_mm_loadu_si128((const __m128i *)&in[4 * q]), shift);
+    }
+
+    for (size_t k = nbits; k-- > 0;)
+    {
+        uint32_t word = 0;
+
+        for (size_t q = 0; q < 8; q++)
+        {
+            word |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(v[q])) << (4 * q);
+            v[q] = _mm_slli_epi32(v[q], 1);
+        }
+
+        out[k] = word;
+    }
+}
+
+#endif
+
+void bitslice32(size_t nbits, uint32_t out[nbits], const uint32_t in[32])
+{
+#if defined(TRANSPOSE_SIMD)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        bitslice32_avx2(nbits, out, in);
+    }
+    else
+    {
+        bitslice32_sse2(nbits, out, in);
+    }
+#elif defined(TRANSPOSE_NAIVE)
+    for (size_t k = 0; k < nbits; k++)
+    {
+        out[k] = 0;
+
+        for (size_t i = 0; i < 32; i++)
+        {
+            out[k] |= ((in[i] >> k) & 1) << i;
+        }
+    }
+#else
+    uint32_t a[32];
+
+    for (size_t i = 0; i < 32; i++)
+    {
+        a[i] = in[i];
+    }
+
+    transpose32(a);
+
+    for (size_t k = 0; k < nbits; k++)
+    {
+        out[k] = a[k];
+    }
+#endif
+}
+
+void bitslice64(size_t nbits, uint64_t out[nbits], const uint32_t in[64])
+{
+#if defined(TRANSPOSE_SIMD)
+    uint32_t lo[nbits], hi[nbits];
+
+    bitslice32(nbits, lo, in);
+    bitslice32(nbits, hi, &in[32]);
+
+    for (size_t k = 0; k < nbits; k++)
+    {
+        out[k] = ((uint64_t)hi[k]) << 32 | lo[k];
+    }
+#elif defined(TRANSPOSE_NAIVE)
+    for (size_t k = 0; k < nbits; k++)
+    {
+        out[k] = 0;
+
+        for (size_t i = 0; i < 64; i++)
+        {
+            out[k] |= ((uint64_t)((in[i] >> k) & 1)) << i;
+        }
+    }
+#else
+    uint64_t a[64];
+
+    for (size_t i = 0; i < 64; i++)
+    {
+        a[i] = in[i];
+    }
+
+    transpose64(a);
+
+    for (size_t k = 0; k < nbits; k++)
+    {
+        out[k] = a[k];
+    }
+#endif
+}
+
+void unbitslice32(size_t nbits, uint32_t out[32], const uint32_t in[nbits])
+{
+#ifdef TRANSPOSE_NAIVE
+    for (size_t i = 0; i < 32; i++)
+    {
+        out[i] = 0;
+
+        for (size_t k = 0; k < nbits; k++)
+        {
+            out[i] |= ((in[k] >> i) & 1) << k;
+        }
+    }
+#else
+    for (size_t k = 0; k < 32; k++)
+    {
+        out[k] = (k < nbits) ? in[k] : 0;
+    }
+
+    transpose32(out);
+#endif
+}
+
+void unbitslice64(size_t nbits, uint32_t out[64], const uint64_t in[nbits])
+{
+#ifdef TRANSPOSE_NAIVE
+    for (size_t i = 0; i < 64; i++)
+    {
+        out[i] = 0;
+
+        for (size_t k = 0; k < nbits; k++)
+        {
+            out[i] |= (uint32_t)((in[k] >> i) & 1) << k;
+        }
+    }
+#else
+    uint64_t a[64];
+
+    for (size_t k = 0; k < 64; k++)
+    {
+        a[k] = (k < nbits) ? in[k] : 0;
+    }
+
+    transpose64(a);
+
+    for (size_t i = 0; i < 64; i++)
+    {
+        out[i] = (uint32_t)a[i];
+    }
+#endif
+}
@@ -0,0 +1,57 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2021-2022: imec-COSIC KU Leuven, 3001 Leuven, Belgium
+ * Authors: Michiel Van Beirendonck <michiel.vanbeirendonck@esat.kuleuven.be>
+ *          Jan-Pieter D'Anvers <janpieter.danvers@esat.kuleuven.be>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) && !defined(TRANSPOSE_NO_SIMD) && !defined(TRANSPOSE_NAIVE)
+    #define TRANSPOSE_SIMD
+    #define TRANSPOSE_VARIANT "movemask"
+#elif defined(TRANSPOSE_NAIVE)
+    #define TRANSPOSE_VARIANT "naive"
+#else
+    #define TRANSPOSE_VARIANT "block-swap"
+#endif
+
+/*
+* Bit-matrix transposes for the bitsliced engine: bit i of bit plane k is bit k of word i.
+* transpose32/64 swap blocks in log2(32)/log2(64) rounds of masked swaps. bitslice32/64 keep nbits planes of
+* 32/64 words (nbits <= 32), unbitslice32/64 are their inverse and pad the missing planes with zeros.
+* On x86-64 hosts bitslice32/64 use SSE2/AVX2 movemasks instead (one mask per plane and vector of words), unless TRANSPOSE_NO_SIMD.
+* TRANSPOSE_NAIVE falls back to the bit-by-bit loops, for comparison with BENCH_A2B.
+*/
+void transpose32(uint32_t a[32]);
+void transpose64(uint64_t a[64]);
+
+void bitslice32(size_t nbits, uint32_t out[nbits], const uint32_t in[32]);
+void bitslice64(size_t nbits, uint64_t out[nbits], const uint32_t in[64]);
+void unbitslice32(size_t nbits, uint32_t out[32], const uint32_t in[nbits]);
+void unbitslice64(size_t nbits, uint32_t out[64], const uint64_t in[nbits]);
+
+#endif // TRANSPOSE_H